@@ -9,6 +9,7 @@
 #include "Waves.h"
 #include "YTML.h"
 #include "Yscript.h"
+#include "Simulation/Simulation.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -67,211 +68,15 @@ enum class RenderLayer : int
 	Water,
 	Count
 };
-template<typename T>
-Color32 rgb2dex(const T& r, const T& g, const T& b)
+inline XMFLOAT3 ToXM(const Float3& v)
 {
-	return ((r * 256) + g) * 256 + b;
+	return XMFLOAT3(v.x, v.y, v.z);
 }
-
-void dex2rgb(float& r, float& g, float& b, const Color32& dex)
-{
-	r = ((dex & 16711680) / 65536) / 255.f;
-	g = ((dex & 65208) / 256) / 255.f;
-	b = (dex & 255) / 255.f;
-}
-void dex2rgb(unsigned char& r, unsigned char& g, unsigned char& b, const Color32& dex)
+inline XMFLOAT4 ToXM(const Float4& v)
 {
-	r = static_cast<unsigned char>((dex & 16711680) / 65536);
-	g = static_cast<unsigned char>((dex & 65208) / 256);
-	b = static_cast<unsigned char>((dex & 255));
+	return XMFLOAT4(v.x, v.y, v.z, v.w);
 }
-void dex2rgb(unsigned int& r, unsigned int& g, unsigned int& b, const Color32& dex)
-{
-	r = (dex & 16711680) / 65536;
-	g = (dex & 65208) / 256;
-	b = (dex & 255);
-}
-
-struct Province {
-	std::wstring name;
-	Color32 color;
-	std::uint64_t p_num = 1;
-	XMFLOAT3 pixel;
-	XMFLOAT3 on3Dpos;
 
-
-	bool is_rebel = false;
-	NationId owner = 0;
-	NationId ruler = 0;
-
-	std::int64_t man = 1000 + rand() % 1600;
-	std::int64_t maxman = 4000 + rand() % 6400;
-	std::int64_t hp = 1000;
-
-	float length_from_contry_side = 0;
-	float prioriy, require;
-
-	Province()
-	{
-	}
-	Province(std::wstring _name, Color32 _color, XMFLOAT3 _pixel) :name(_name), color(_color), pixel(_pixel)
-	{
-
-	}
-};
-
-using WCHAR3 = WCHAR[3];
-struct Nation
-{
-	XMFLOAT4 MainColor = { 0.f, 0.f, 0.f, 0.f };
-	std::wstring MainName = L"";
-	std::unordered_map<std::wstring, std::wstring> flag;
-	bool Ai = true;
-
-	float abb_disp = 1;
-	float abb_man = 1;
-	float abb_army_sieze = 1;
-	float abb_army_move = 1;
-	float abb_attr = 1;
-
-	size_t own_province = 0;
-	size_t rule_province = 0;
-	size_t own_leaders = 0;
-
-	NationId rival = -1;
-};
-enum class CommandType
-{
-	Move,
-	Sieze,
-	Attack
-};
-struct Command
-{
-	const CommandType type;
-	const ProvinceId target_prov;
-	const LeaderId target_leader;
-	const float need;
-	Command(const CommandType _type, const ProvinceId prov = 0, const LeaderId leader = 0, const float _need = 0) : type(_type), target_prov(prov), target_leader(leader), need(_need) {}
-};
-
-enum class LeaderType
-{
-	Attack,
-	Defend,
-	All
-};
-struct Leader
-{
-	std::list<Command> cmd;
-	float cmd_pr = 0.f;
-	bool enable = true;
-	ProvinceId location;
-	bool selected = false;
-
-	std::int64_t size = 1000;
-	LeaderType type = (LeaderType)(rand() % (int)LeaderType::All);
-
-	float abb_sieze = 1;
-	float abb_move = 1;
-	float abb_disp = 1;
-
-	NationId owner;
-	Leader(const ProvinceId& loc, const NationId& own, const std::int64_t& _size) : location(loc), owner(own), size(_size) {};
-};
-enum class ProvincePathOutState {
-	NotOut,
-	WaitOut,
-	Out
-};
-struct ProvincePathNode
-{
-	float Length = FLT_MAX;
-	ProvinceId Nearest = 0;
-	ProvincePathOutState Out = ProvincePathOutState::NotOut;
-};
-struct ProvincePath
-{
-	std::list<ProvinceId> path;
-	std::map<ProvinceId, ProvincePathNode> prv;
-	float length;
-	decltype(path)::iterator begin() { return path.begin(); }
-	decltype(path)::iterator end() { return path.end(); }
-
-	ProvincePath(const std::map<ProvinceId, std::unique_ptr<Province>>&  _prv, const std::map<std::pair<ProvinceId, ProvinceId>, float> conn, const ProvinceId& Start, const ProvinceId& End)
-	{
-		if (Start == End) return;
-		for (const auto& O : _prv) prv[O.first] = ProvincePathNode();
-
-		prv.at(End).Length = 0;
-		prv.at(End).Out = ProvincePathOutState::WaitOut;
-
-		size_t limit = 0;
-		while (limit++ <= prv.size())
-		{
-			for (auto& O : prv)
-			{
-				if (O.second.Out == ProvincePathOutState::WaitOut)
-				{
-					for (auto& P : prv)
-					{
-						if (P.second.Out == ProvincePathOutState::NotOut)
-						{
-							if (auto Q = conn.find(std::make_pair(O.first, P.first)); Q != conn.end())
-							{
-								if (P.second.Length > O.second.Length + Q->second)
-								{
-									P.second.Length = O.second.Length + Q->second;
-									P.second.Nearest = O.first;
-								}
-							}
-						}
-					}
-					O.second.Out = ProvincePathOutState::Out;
-				}
-			}
-
-			/*if (prv.at(Start).Out == ProvincePathOutState::Out)
-			{
-				break;
-			}*/
-
-			float meter = FLT_MAX;
-			decltype(prv)::iterator itr = prv.end();
-			for (auto O = prv.begin(); O != prv.end(); ++O)
-			{
-				if (O->second.Out == ProvincePathOutState::NotOut && meter > O->second.Length)
-				{
-					meter = O->second.Length;
-					itr = O;
-				}
-			}
-			if (itr != prv.end())
-			{
-				itr->second.Out = ProvincePathOutState::WaitOut;
-			}
-			else
-			{
-				break;
-			}
-		}
-
-		if (prv.at(Start).Out != ProvincePathOutState::NotOut)
-		{
-			ProvinceId Index = Start;
-			length = prv.at(Start).Length;
-			do
-			{
-				Index = prv.at(Index).Nearest;
-				path.push_back(Index);
-			} while (Index != End);
-		}
-	}
-	ProvincePath() 
-	{
-
-	};
-};
 class Arrows
 {
 public:
@@ -341,34 +146,6 @@ public:
 		BuildLine();
 	}
 };
-struct Data
-{
-	bool run = true;
-
-	std::map<ProvinceId, std::unique_ptr<Province>> province;
-	std::map<std::pair<ProvinceId, ProvinceId>, float> province_connect;
-	std::unordered_map<NationId, std::unique_ptr<Nation>>  nations;
-
-	std::unordered_map<LeaderId, std::shared_ptr<Leader>> leaders;
-	std::uint64_t leader_progress = 1;
-
-	LeaderId last_leader_id = 0;
-	ProvinceId last_prov_id = 0;
-
-	std::random_device rd;
-	std::mt19937 mt;
-
-	Data()
-	{
-		mt = std::mt19937(rd());
-	}
-
-	Leader NewLeader(const ProvinceId& loc, const NationId& own, const std::int64_t& _size)
-	{
-		return Leader(loc, own, _size);
-	}
-};
-
 enum class DragType
 {
 	None,
@@ -446,7 +223,6 @@ private:
 	void InsertArrow(const ProvinceId& start, ProvincePath& path, bool clear);
 	void UpdateArrow();
 	
-	void Query(const std::wstring& query);
 	void Execute(const std::wstring& func_name, const std::uint64_t& uuid);
 
 	void MainGame();
@@ -455,6 +231,11 @@ private:
 private:
 	void GUIUpdatePanelLeader(LeaderId leader_id = 0);
 	void GUIUpdatePanelProvince(ProvinceId prov_id = 0);
+	void GUISyncLeaders();
+	// Deselects every leader in the UI; PostSelection then tells the simulation.
+	void ClearSelection();
+	void PostSelection();
+	std::vector<LeaderId> SelectedLeaders() const;
 
 	UINT mCbvSrvDescriptorSize = 0;
 
@@ -510,11 +291,8 @@ private:
 	} mUser;
 
 
-
-	std::unordered_map<std::wstring, std::wstring> Act(std::wstring wstr, std::initializer_list<std::wstring> args, bool need_return = false, bool try_lock = true);
-
-
-	std::shared_ptr<Data> m_gamedata = std::make_shared<Data>();
+	std::unique_ptr<Simulation> m_sim = std::make_unique<Simulation>();
+	std::shared_ptr<Data> m_gamedata = m_sim->data;
 
 	XMVECTOR mEyetarget = XMVectorSet(0.0f, 15.0f, 0.0f, 0.0f);
 
@@ -529,23 +307,16 @@ private:
 
 	bool mUI_isInitial = false;
 
-	struct Query
-	{
-		bool enable = false;
-
-		bool isString = false;
-		bool isLineComment = false;
-		bool isComment = false;
-
-		size_t pos;
-		std::list<std::wstring> word;
-		std::wstring index;
-
-		ProvinceId tag_prov;
-		LeaderId tag_leader;
-		decltype(Data::province)::iterator tag_prov_it;
-
-	} mQuery;
+	// Leaders that already have their widgets in m_DrawItems.
+	std::unordered_set<LeaderId> mLeaderWidgets;
+	// Leaders selected in the UI.  Only this thread touches it; the simulation keeps
+	// its own copy through SelectCommand.
+	std::unordered_set<LeaderId> mSelected;
+	// Raised by MainGame after a tick so GameUpdate redraws the panels on this thread.
+	std::atomic<bool> mTicked{ false };
+	std::atomic<bool> mLeadersChanged{ false };
+	// Raised once the simulation thread has written a save posted by GameSave.
+	std::atomic<bool> mSaved{ false };
 
 	D2D1_POINT_2F Draw_point;
 	D2D1_RECT_F Draw_rect;
@@ -559,8 +330,13 @@ private:
 	int dragx, dragy;
 
 	GameControlType game_contype = GameControlType::View;
-	
-	std::mutex draw_mutex;
+
+	// Latest simulation state, taken once a frame by GameUpdate.  The UI reads the
+	// campaign only through it, besides map data and nations fixed at load.
+	const RenderSnapshot* mView = nullptr;
+	// Leader or province shown in the panel; 0 for none.
+	LeaderId mLastLeader = 0;
+	ProvinceId mLastProv = 0;
 
 };
 
@@ -603,449 +379,12 @@ void MyApp::MainGame() //!@
 	//std::this_thread::sleep_for(std::chrono::seconds(1));	
 
 	OutputDebugStringA("Start Thread\n");
-	float NowTime = mTimer.TotalTime();
-	bool flag_update_leaders = false;
 	while (m_gamedata->run)
 	{
-		for (auto& N : m_gamedata->nations)
-		{
-			N.second->own_province = 0;
-			N.second->rule_province = 0;
-			N.second->own_leaders = 0;
-		}
-		for (auto& O : m_gamedata->province)
-		{
-			O.second->man += (int64_t)round(min(max((O.second->maxman - O.second->man)/1200.0,-10),10));
-			
-			if (O.second->owner != O.second->ruler && O.second->man > O.second->maxman / 4)
-			{
-				if (O.second->man + O.second->hp * 2 > rand() % (1 + (int)(1.0 * rand() / RAND_MAX * 30000)) + O.second->maxman / 4)
-				{
-					Act(L"Draft", { L"location", Str(O.first), L"size", Str(O.second->man), L"owner", Str(O.second->owner) });
-				}
-			}
-			if (O.second->owner == O.second->ruler)
-			{
-				auto& N = m_gamedata->nations.find(O.second->ruler);
-				if (N != m_gamedata->nations.end())
-				{
-					O.second->man += (int64_t)round(min(max((O.second->maxman - O.second->man) / 1200.0 * N->second->abb_man, -10), 10));
-				}
-				else if (O.second->hp < O.second->p_num / 5 && O.second->man > 6000)
-				{
-					Act(L"Draft", { L"location", Str(O.first), L"size", Str(O.second->man), L"owner", Str(O.second->owner) });
-				}
-			}
-
-			if (auto& N = m_gamedata->nations.find(O.second->owner); N != m_gamedata->nations.end()) ++N->second->own_province;
-			if (auto& N = m_gamedata->nations.find(O.second->ruler); N != m_gamedata->nations.end()) ++N->second->rule_province;
-			
-
-			if (O.second->hp < 0) O.second->hp = 0;
-			else if (O.second->hp >= O.second->p_num)
-			{
-				O.second->hp = O.second->p_num;
-				O.second->owner = O.second->ruler;
-			}
-			else O.second->hp += 1;
-
-			if (m_gamedata->last_prov_id == O.first)
-			{
-				GUIUpdatePanelProvince();
-			}
-
-			
-		}
-
-		draw_mutex.lock();
-
-		for (auto O = m_gamedata->leaders.begin(); O != m_gamedata->leaders.end(); ++O)
-		{
-			if (O->second->size <= 0)
-			{
-				if (m_gamedata->last_leader_id == O->first) m_gamedata->last_leader_id = 0;
-				
-				for (const auto& E : m_DrawItems->$(L"#leader" + Str(O->first) + L" flag")) m_DrawItems->data.erase(E);
-				for (const auto& E : m_DrawItems->$(L"#leader" + Str(O->first) + L" state")) m_DrawItems->data.erase(E);
-				for (const auto& E : m_DrawItems->$(L"#leader" + Str(O->first) + L" num")) m_DrawItems->data.erase(E);
-				for (const auto& E : m_DrawItems->$(L"#leader" + Str(O->first) + L" background")) m_DrawItems->data.erase(E);
-				for (const auto& E : m_DrawItems->$(L"#leader" + Str(O->first) + L" progress")) m_DrawItems->data.erase(E);
-				for (const auto& E : m_DrawItems->$(L"#leader" + Str(O->first))) m_DrawItems->data.erase(E);
-				m_gamedata->leaders.erase((O--)->first);
-			}
-			else
-			{
-				if (auto& N = m_gamedata->nations.find(O->second->owner); N != m_gamedata->nations.end()) ++N->second->own_leaders;
-			}
-		}
-		draw_mutex.unlock();
-
-		flag_update_leaders = false;
-		for (auto& O : m_gamedata->leaders)
-		{
-			if (O.second->owner != m_gamedata->province.at(O.second->location)->ruler)
-			{
-				if (const auto & N = m_gamedata->nations.find(m_gamedata->province.at(O.second->location)->ruler); N != m_gamedata->nations.end())
-				{
-					O.second->size -= (std::int64_t)std::round(O.second->size * N->second->abb_attr / 10000.f * 2 * rand() / RAND_MAX);
-				}
-				else
-				{
-					O.second->size -= (std::int64_t)std::round(O.second->size * 5 / 10000.f * 2 * rand() / RAND_MAX);
-				}
-				///if (O.second->size > 1000) O.second->size -= (O.second->size - 1000) / 10000;
-			}
-			else 
-			{
-				if (auto& P = m_gamedata->province.at(O.second->location); true)
-				{
-					if (P->owner == P->ruler)
-					{
-						if (O.second->owner == P->owner)
-						{
-							for (int i = 1; i < 100 && i * i * 9 <= P->man; ++i)
-							{
-								O.second->size += 9 * i * i;
-								P->man -= 9 * i * i;
-							}
-						}
-					}
-					else if (P->ruler == O.second->owner)
-					{
-						if (P->hp < P->p_num) P->hp += 1;
-					}
-				}
-			}
-			if (O.second->cmd.size() > 0)
-			{
-				auto B = O.second->cmd.begin();
-
-				if (O.second->cmd_pr >= B->need)
-				{
-					O.second->cmd_pr = 0;
-
-					switch (B->type)
-					{
-					case CommandType::Move:
-						O.second->location = B->target_prov;
-						break;
-					case CommandType::Sieze:
-						{
-							auto& P = m_gamedata->province.at(O.second->location);
-							P->hp -= (77 + rand() % 100 + O.second->size / 600) * 2;
-							//O.second->size = (int)(0.9 * O.second->size);
-							if (P->hp <= 0)
-							{
-								P->ruler = O.second->owner;
-								//O.second->size += m_gamedata->province.at(O.second->location)->man;
-								//m_gamedata->province.at(O.second->location)->man = 0;
-								P->hp = 0;
-							}
-						}
-						break;
-					case CommandType::Attack:
-						auto L = m_gamedata->leaders.find(std::move(B->target_leader));
-						if (L != m_gamedata->leaders.end() && L->second->location == O.second->location && O.second->size > 0 && L->second->size > 0)
-						{
-							if (L->second->owner == m_gamedata->province.at(O.second->location)->owner) {
-								L->second->size -= O.second->size / 4 * 170 / 200;
-							}
-							else {
-								L->second->size -= O.second->size / 4;
-							}
-							
-							if (L->second->size > 0)
-							{
-								O.second->size -= L->second->size / 4;
-								if (L->second->cmd.size() > 0 && (L->second->cmd.begin()->type == CommandType::Sieze || L->second->cmd.begin()->type == CommandType::Move))
-								{
-									L->second->cmd_pr = 0;
-									L->second->cmd.pop_front();
-								}
-							}
-						}
-						break;
-					}
-					O.second->cmd.pop_front();
-				}
-				else
-				{
-					switch (B->type)
-					{
-					case CommandType::Sieze:
-						if (m_gamedata->province.at(O.second->location)->ruler == O.second->owner)
-						{
-							O.second->cmd.pop_front();
-							O.second->cmd_pr = -1;
-						}
-						break;
-					case CommandType::Attack:
-						auto L = m_gamedata->leaders.find(std::move(B->target_leader));
-						if (L == m_gamedata->leaders.end())
-						{
-							O.second->cmd.pop_front();
-							O.second->cmd_pr = -1;
-						}
-						else if (L->second->location != O.second->location)
-						{
-							O.second->cmd.pop_front();
-							O.second->cmd_pr = -1;
-						}
-						break;
-					}
-					O.second->cmd_pr += 1;
-				}
-				if (O.second->selected) flag_update_leaders = true;
-
+		m_sim->Step(1);
 
-			}
-			else
-			{
-				std::vector<LeaderId> sameLocLeader;
-				for (auto& L : m_gamedata->leaders)
-				{
-					if (L.second->location == O.second->location && L.second->owner != O.second->owner)
-					{
-						if (L.second->cmd.size() > 0 && L.second->cmd.begin()->type == CommandType::Sieze)
-						{
-							sameLocLeader.clear();
-							sameLocLeader.push_back(L.first);
-							break;
-						}
-						else
-						{
-							sameLocLeader.push_back(L.first);
-						}
-					}
-				}
-				std::shuffle(sameLocLeader.begin(), sameLocLeader.end(), m_gamedata->rd);
-				if (sameLocLeader.size() > 0) O.second->cmd.push_back(Command(CommandType::Attack, 0, *sameLocLeader.begin(), 10));
-				else if (m_gamedata->province.at(O.second->location)->ruler != O.second->owner)
-				{
-					O.second->cmd.push_back(Command(CommandType::Sieze, O.second->location, 0, 20 / O.second->abb_sieze));
-				}
-				else
-				{
-					if (m_gamedata->province.at(O.second->location)->hp < 1000) m_gamedata->province.at(O.second->location)->hp += O.second->size / 1000;
-				}
-			}
-		}
-
-
-		//AI
-		for (auto& N : m_gamedata->nations)
-		{
-			if (N.second->Ai && N.second->own_province > 0 && N.second->rule_province > 0)
-			{
-				if (N.second->rival != -1)
-				{
-					if (auto & n = m_gamedata->nations.find(N.second->rival); n != m_gamedata->nations.end())
-					{
-						if (n->second->own_province == 0 && n->second->rule_province == 0)
-						{
-							N.second->rival = -1;
-						}
-					}
-					else
-					{
-						N.second->rival = -1;
-					}
-				}
-
-				std::list<ProvinceId> myProv;
-				std::list<LeaderId> myLead;
-
-				for (auto& P : m_gamedata->province) 
-				{ 
-					if (P.second->owner == N.first || P.second->ruler == N.first) myProv.push_back(P.first); 
-
-					if (P.second->owner == N.first)
-					{
-						if (P.second->ruler == N.first) //   
-						{
-							P.second->prioriy = 1 * (2000 - P.second->hp);
-						}
-						else							//   
-						{
-							P.second->prioriy = 3 * (2000 - P.second->hp);
-						}
-					}
-					else
-					{
-						if (P.second->ruler == N.first)	 //   
-						{
-							P.second->prioriy = 2 * (2000 - P.second->hp) * (N.second->rival == P.second->ruler ? 2 : 1);
-						}
-						else							 //   
-						{
-							P.second->prioriy = 1 * (2000 - P.second->hp) * (N.second->rival == P.second->ruler ? 2 : 1);
-						}
-					}
-				}
-				for (auto& L : m_gamedata->leaders) 
-				{ 
-					ProvinceId lastLoc = L.second->location;
-					if (L.second->cmd.size() > 0)
-					{
-						float rate_time = -L.second->cmd_pr;
-						for (auto& C : L.second->cmd)
-						{
-							rate_time += C.need;
-							if (C.type == CommandType::Move) lastLoc = C.target_prov;
-						}
-					}
-					auto& P = m_gamedata->province.at(lastLoc);
-
-					if (L.second->owner == N.first)
-					{
-						myLead.push_back(L.first);
-						P->require -= L.second->size;
-						if (P->ruler == N.first)//    
-							P->prioriy -= 2 * L.second->size;
-						else					//    
-							P->prioriy -= 0.1f * L.second->size * (N.second->rival == P->owner ? 0.5f : 1.f);
-					}
-					else
-					{
-						P->require += L.second->size;
-						if (P->ruler == N.first)//    
-							P->prioriy += 2 * L.second->size * (N.second->rival == P->owner ? 2 : 1);
-						else					//    
-							P->prioriy -= 1 * L.second->size * (N.second->rival == P->owner ? 0.5 : 1);
-					}
-				}
-
-				if (N.second->rival == -1)
-				{
-					float syn = -FLT_MAX;
-					for (auto& n : m_gamedata->nations)
-					{
-						if (n.second->own_province > 0 && n.second->rule_province > 0 && n.first != N.first)
-						{
-							float my_syn = 0;
-							for (auto& P : m_gamedata->province)
-							{
-								if (P.second->owner == N.first && P.second->ruler == n.first)
-								{
-									my_syn += P.second->maxman / 1000.f;
-								}
-								else if (P.second->ruler == N.first && P.second->owner == n.first)
-								{
-									my_syn += P.second->maxman / 1000.f;
-								}
-								else if (P.second->ruler == n.first && P.second->owner == n.first)
-								{
-									float distance = FLT_MAX;
-									for (const auto& p : myProv)
-									{
-										auto path = ProvincePath(m_gamedata->province, m_gamedata->province_connect, P.first, p);
-										if (path.path.size() > 0)
-										{
-											if (path.length < distance)
-												distance = path.length;
-										}
-									}
-									my_syn += (P.second->maxman / 1000.f) * 30 / pow(distance, 2);
-								}
-							}
-							if (my_syn > syn)
-							{
-								syn = my_syn;
-								N.second->rival = n.first;
-							}
-						}
-					}
-				}
-
-				size_t LeaderCount = myLead.size();
-				for (const auto& p : myProv)
-				{
-					if (LeaderCount >= myProv.size() / 2 + 1 ) break;
-					auto& P = m_gamedata->province[p];
-					if (N.first == P->ruler && P->man >= 1000)
-					{
-						if (auto X = Act(L"Draft", { L"location", Str(p), L"size", Str(P->man), L"owner", Str(P->owner), L"abb_sieze", Str(N.second->abb_army_sieze), L"abb_move", Str(N.second->abb_army_move) }); X.find(L"SUCCESS") != X.end()) ++LeaderCount;
-					}
-				}
-
-				for (const auto& l : myLead)
-				{
-					auto& L = m_gamedata->leaders[l];
-					if (L->cmd.size() == 0)
-					{
-						ProvinceId target = L->location;
-						float org_syn = m_gamedata->province[L->location]->prioriy + L->size;
-						float syn = org_syn;
-						float tmp = 0;
-
-						for (auto& P : m_gamedata->province)
-						{
-							if (P.second->prioriy < org_syn) continue;
-							auto path = ProvincePath(m_gamedata->province, m_gamedata->province_connect, L->location, P.first);
-							if (syn < P.second->prioriy - path.length * 16)
-							{
-								syn = P.second->prioriy - path.length * 16;
-								target = P.first;
-							}
-						}
-
-						auto path = ProvincePath(m_gamedata->province, m_gamedata->province_connect, L->location, target);
-
-						if (path.path.size() > 0)
-						{
-							m_gamedata->province[target]->prioriy -= L->size;
-							m_gamedata->province[L->location]->prioriy += L->size;
-
-							L->cmd_pr = 0;
-							L->cmd.clear();
-							ProvinceId lastLoc = L->location;
-							for (auto P : path)
-							{
-								L->cmd.push_back(Command(CommandType::Move, P, 0, m_gamedata->province_connect.at(std::make_pair(lastLoc, P)) / L->abb_move));
-								lastLoc = P;
-								break;
-							}
-						}						
-					}
-				}
-
-
-
-			}
-			else
-			{
-				size_t myProvCount = 0;
-				size_t myLeaderCount = 0;
-				for (auto& P : m_gamedata->province)
-				{
-					if (P.second->ruler == N.first || P.second->owner == N.first) ++myProvCount;
-				}
-				for (auto& L : m_gamedata->leaders)
-				{
-					ProvinceId lastLoc = L.second->location;
-					auto& P = m_gamedata->province.at(lastLoc);
-
-					if (L.second->owner == N.first) ++myLeaderCount;
-				}
-				for (auto& P : m_gamedata->province)
-				{
-					if (!(myLeaderCount < myProvCount / 2 + 1))break;
-					if (N.first == P.second->ruler && P.second->man >= 1000)
-					{
-
-						Act(L"Draft", { L"location", Str(P.first), L"size", Str(P.second->man), L"owner", Str(P.second->owner), L"abb_sieze", Str(N.second->abb_army_sieze), L"abb_move", Str(N.second->abb_army_move) });
-
-						++myLeaderCount;
-					}
-				}
-			}
-		}
-
-		if (flag_update_leaders)
-		{
-			UpdateArrow();
-			GUIUpdatePanelLeader();
-		}
+		if (m_sim->flag_update_leaders) mLeadersChanged = true;
+		mTicked = true;
 
 		std::this_thread::sleep_for(std::chrono::milliseconds(100));
 	}
@@ -1235,7 +574,6 @@ void MyApp::DrawUI()
 		m_d2d->textFormat[L"Debug"].Get(), D2D1::RectF(0.0f, 0.0f, mClientWidth / 3.f, 1.f * mClientHeight),
 		m_d2d->Brush[L"White"].Get());
 
-	draw_mutex.lock();
 	m_DrawItems->Sort();
 	for (auto& O : m_DrawItems->data)
 	{
@@ -1342,7 +680,6 @@ void MyApp::DrawUI()
 			O[L"enable"] = L"disable";
 		}
 	}
-	draw_mutex.unlock();
 }
 void MyApp::Draw(const GameTimer& gt)
 {
@@ -1378,202 +715,55 @@ void MyApp::Draw(const GameTimer& gt)
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Province]);
 
 	mCommandList->SetPipelineState(mPSOs["transparent"].Get());
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Water]); 
-
-	mCommandList->SetPipelineState(mPSOs["alphaTested"].Get());
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Transparent]);
-
-	ThrowIfFailed(mCommandList->Close());
-
-	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
-	mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
-
-
-	{
-		int m_frameIndex = mCurrBackBuffer;
-		ID3D11Resource* ppResources[] = { m_d2d->wrappedRenderTargets[m_frameIndex].Get() };
-
-		m_d2d->d2dDeviceContext->SetTarget(m_d2d->d2dRenderTargets[m_frameIndex].Get());
-
-		m_d2d->d3d11On12Device->AcquireWrappedResources(ppResources, _countof(ppResources));
-		m_d2d->d2dDeviceContext->BeginDraw();
-
-		DrawUI();
-
-		m_d2d->d2dDeviceContext->EndDraw();
-		m_d2d->d3d11On12Device->ReleaseWrappedResources(ppResources, _countof(ppResources));
-
-		m_d2d->d3d11DeviceContext->Flush();
-
-	}
-	ThrowIfFailed(mSwapChain->Present(0, 0));
-	mCurrBackBuffer = (mCurrBackBuffer + 1) % SwapChainBufferCount;
-
-	mCurrFrameResource->Fence = ++mCurrentFence;
-
-	mCommandQueue->Signal(mFence.Get(), mCurrentFence);
-}
-
-void MyApp::Query(const std::wstring& query)
-{
-	if (mQuery.enable)
-	{
-		if (query == L"SAVE\tEND")
-		{
-			mQuery.enable = false;
-			OutputDebugStringW(L"SAVE END\n");
-			return;
-		}
-
-
-		mQuery.word.clear();
-
-		for (mQuery.pos = 0; mQuery.pos < query.size(); ++mQuery.pos)
-		{
-			auto ch = query.at(mQuery.pos);
-
-			if (mQuery.isLineComment)
-			{
-				if (ch == L'\n' || ch == L'\r')
-					mQuery.isLineComment = false;
-			}
-			else if (mQuery.isComment)
-			{
-				if (ch == L'*' && mQuery.pos + 1 < query.size())
-					if (query.at(mQuery.pos + 1) == L'*')
-					{
-						mQuery.isComment = false;
-						++mQuery.pos;
-					}
-			}
-			else if (ch == L'"')
-				mQuery.isString = !mQuery.isString;
-			else if (mQuery.isString)
-				mQuery.word.rbegin()->push_back(ch);
-			else if (ch == L'\t' || ch == L' ' || ch == L'\n' || ch == L'\r')
-			{
-				mQuery.word.push_back(L"");
-			}
-			else if (ch == L'/' && mQuery.pos + 1 < query.size())
-				if (query.at(mQuery.pos + 1) == L'/')
-				{
-					mQuery.isLineComment = true;
-					++mQuery.pos;
-				}
-				else if (query.at(mQuery.pos + 1) == L'*')
-				{
-					mQuery.isComment = true;
-					++mQuery.pos;
-				}
-				else
-					mQuery.word.rbegin()->push_back(ch);
-			else
-				mQuery.word.rbegin()->push_back(ch);
-		}
+	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Water]); 
 
-		while (mQuery.word.size() > 0 && (*mQuery.word.cbegin() == L""))
-		{
-			mQuery.word.pop_front();
-		}
-		if (mQuery.word.size() > 0)
-		{			
-			mQuery.index = L"";
-			if (*mQuery.word.cbegin() == L"PROVINCE")
-			{
-				mQuery.tag_prov_it = m_gamedata->province.end();
+	mCommandList->SetPipelineState(mPSOs["alphaTested"].Get());
+	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Transparent]);
+
+	ThrowIfFailed(mCommandList->Close());
+
+	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
+	mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
 
-				for (auto O : mQuery.word)
-				{
-					if (O.at(0) == L'-')
-						mQuery.index = O;
-					else
-					{
-						if (mQuery.index == L"-id")
-						{
-							mQuery.tag_prov = Long(O);
-							mQuery.tag_prov_it = m_gamedata->province.find(mQuery.tag_prov);
-						}
-						else if (mQuery.index == L"-ruler")
-						{
-							if (mQuery.tag_prov_it != m_gamedata->province.end())
-							{
-								for (const auto& N : m_gamedata->nations)
-								{
-									if (N.second->MainName == O)
-									{
-										mQuery.tag_prov_it->second->ruler = N.first;
-										break;
-									}
-								}
-							}
-						}
-						else if (mQuery.index == L"-owner")
-						{
-							if (mQuery.tag_prov_it != m_gamedata->province.end())
-							{
-								for (const auto& N : m_gamedata->nations)
-								{
-									if (N.second->MainName == O)
-									{
-										mQuery.tag_prov_it->second->owner = N.first;
-										break;
-									}
-								}
-							}
-						}
-						else if (mQuery.index == L"-develop")
-						{
-							if (mQuery.tag_prov_it != m_gamedata->province.end())
-							{
-								mQuery.tag_prov_it->second->maxman = (4 + powf(Int(O) / 2.f, 2)) * 1000;
-								mQuery.tag_prov_it->second->man = mQuery.tag_prov_it->second->maxman / 10;
-							}
-						}
 
-					}
-				}
-			}
-			
-		}
-		else
-		{
-			OutputDebugStringA("E");
-		}
-	}
-	else if (query == L"SAVE\tSTART")
 	{
-		mQuery.enable = true;
-		OutputDebugStringW(L"SAVE START\n");
-	}
-}
-void MyApp::GameSave()
-{
-	captions[L" "] = L"";
-	std::wofstream file(L"UserData/Nation");
+		int m_frameIndex = mCurrBackBuffer;
+		ID3D11Resource* ppResources[] = { m_d2d->wrappedRenderTargets[m_frameIndex].Get() };
 
+		m_d2d->d2dDeviceContext->SetTarget(m_d2d->d2dRenderTargets[m_frameIndex].Get());
 
-	file << L"SAVE\tSTART" << L";\n";
+		m_d2d->d3d11On12Device->AcquireWrappedResources(ppResources, _countof(ppResources));
+		m_d2d->d2dDeviceContext->BeginDraw();
 
-	for (const auto& O : m_gamedata->province)
-	{
-		file << L"PROVINCE" << L"\t" << L"-id " << std::to_wstring(O.first);
+		DrawUI();
 
-		if (auto find = m_gamedata->nations.find(O.second->ruler); find != m_gamedata->nations.end())
-		{
-			file << L" -ruler " << m_gamedata->nations.at(O.second->ruler)->MainName;
-		}
-		if (auto find = m_gamedata->nations.find(O.second->owner); find != m_gamedata->nations.end())
-		{
-			file << L" -owner " << m_gamedata->nations.at(O.second->owner)->MainName;
-		}
+		m_d2d->d2dDeviceContext->EndDraw();
+		m_d2d->d3d11On12Device->ReleaseWrappedResources(ppResources, _countof(ppResources));
+
+		m_d2d->d3d11DeviceContext->Flush();
 
-		file << L";\n";
 	}
+	ThrowIfFailed(mSwapChain->Present(0, 0));
+	mCurrBackBuffer = (mCurrBackBuffer + 1) % SwapChainBufferCount;
 
-	file << L"SAVE\tEND" << L";\n";
+	mCurrFrameResource->Fence = ++mCurrentFence;
 
-	file.close();
-	captions[L" "] = L"";
+	mCommandQueue->Signal(mFence.Get(), mCurrentFence);
+}
+
+void MyApp::GameSave()
+{
+	captions[L" "] = L"";
+
+	// The scenario is read between ticks on the simulation thread, which writes the
+	// file there as well; GameUpdate reports when it is done.
+	m_sim->Post(SaveCommand{ [this](const std::wstring& scenario)
+	{
+		std::wofstream file(L"UserData/Nation");
+		file << scenario;
+		file.close();
+		mSaved = true;
+	} });
 }
 void MyApp::GameLoad()
 {
@@ -1596,18 +786,7 @@ void MyApp::GameLoad()
 
 	std::wstring wstr;
 	wstr.assign(buf.begin(), buf.end());
-	size_t cursor = 0, next;
-	while (1)
-	{
-		next = wstr.find(L';', cursor);
-		if (next == std::wstring::npos)
-		{
-			Query(wstr.substr(cursor));
-			break;
-		}
-		Query(wstr.substr(cursor, next - cursor));
-		cursor = next + 1;
-	}
+	m_sim->Post(LoadCommand{ wstr });
 
 
 	captions[L" "] = L"";
@@ -1616,183 +795,22 @@ void MyApp::GameLoad()
 
 void MyApp::GameInit()
 {
-	NationId nation_count = 0;
-	{
-		std::unique_ptr<Nation> Ŷ = std::make_unique<Nation>();
-		Ŷ->MainColor = XMFLOAT4(0.5f, 0.5f, 0.1f, 0.75f);
-		Ŷ->MainName = L"Ŷ";
-		Ŷ->abb_attr = 2;
-		m_gamedata->nations[++nation_count] = std::move(Ŷ);
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.1f, 0.5f, 0.45f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-		//mUser.nationPick = nation_count;
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.4f, 0.0f, 0.0f, 0.75f);
-		->MainName = L"";
-		->abb_attr = 3;
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation> 糪 = std::make_unique<Nation>();
-		糪->MainColor = XMFLOAT4(0.8f, 0.5f, 0.0f, 0.75f);
-		糪->MainName = L"糪";
-		m_gamedata->nations[++nation_count] = std::move(糪);
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.25f, 0.0f, 0.0f, 0.75f);
-		->MainName = L"";
-		->abb_man = 1.2f;
-		->abb_attr = 6;
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(1.0f, 0.25f, 0.25f, 0.75f);
-		->MainName = L"";
-		->abb_man = 1.5f;
-		->abb_attr = 12;
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.3f, 0.5f, 0.8f, 0.75f);
-		->MainName = L"";
-		->abb_man = 0.2f;
-		->abb_army_move = 5.f;
-		->abb_army_sieze = 4.f;
-		m_gamedata->nations[++nation_count] = std::move();
-
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.125f, 0.25f, 0.5f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(1.f, 0.f, 0.f, 0.75f);
-		->MainName = L"";
-		->abb_man = 1.25f;
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.25f, 0.5f, 0.0625f, 0.75f);
-		->MainName = L"";
-		->abb_man = 1.5f;
-		->abb_attr = 8;
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation> ѱ = std::make_unique<Nation>();
-		ѱ->MainColor = XMFLOAT4(1.f, 1.f, 1.f, 0.75f);
-		ѱ->MainName = L"ѱ";
-		ѱ->abb_attr = 0.75f;
-		ѱ->abb_man = 10;
-		m_gamedata->nations[++nation_count] = std::move(ѱ);
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.75f, 0.5f, 1.f, 0.75f);
-		->MainName = L"";
-		->abb_attr = 2;
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(1.f, 0.6f, 0.0625f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation> Ž = std::make_unique<Nation>();
-		Ž->MainColor = XMFLOAT4(0.9f, 0.3f, 0.9f, 0.75f);
-		Ž->MainName = L"Ž";
-		m_gamedata->nations[++nation_count] = std::move(Ž);
-
-		std::unique_ptr<Nation> Ŷ = std::make_unique<Nation>();
-		Ŷ->MainColor = XMFLOAT4(0.5f, 0.0f, 0.3f, 0.75f);
-		Ŷ->MainName = L"Ŷ";
-		m_gamedata->nations[++nation_count] = std::move(Ŷ);
-
-
-		std::unique_ptr<Nation> θ = std::make_unique<Nation>();
-		θ->MainColor = XMFLOAT4(0.3f, 0.4f, 0.7f, 0.75f);
-		θ->MainName = L"θ";
-		m_gamedata->nations[++nation_count] = std::move(θ);
-
-
-		std::unique_ptr<Nation> ο = std::make_unique<Nation>();
-		ο->MainColor = XMFLOAT4(0.6f, 0.1f, 0.6f, 0.75f);
-		ο->MainName = L"ο";
-		m_gamedata->nations[++nation_count] = std::move(ο);
-
-
-		std::unique_ptr<Nation> ο = std::make_unique<Nation>();
-		ο->MainColor = XMFLOAT4(0.7f, 0.2f, 0.7f, 0.75f);
-		ο->MainName = L"ο";
-		m_gamedata->nations[++nation_count] = std::move(ο);
-			   
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.4f, 0.1f, 0.1f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.1f, 0.3f, 0.5f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.8f, 0.1f, 0.1f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation> º = std::make_unique<Nation>();
-		º->MainColor = XMFLOAT4(0.8f, 0.8f, 0.3f, 0.75f);
-		º->MainName = L"º";
-		m_gamedata->nations[++nation_count] = std::move(º);
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.8f, 0.8f, 0.6f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.6f, 0.8f, 0.1f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.1f, 0.2f, 0.9f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(1.0f, 0.5f, 0.5f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-
-		std::unique_ptr<Nation>  = std::make_unique<Nation>();
-		->MainColor = XMFLOAT4(0.2f, 0.2f, 0.2f, 0.75f);
-		->MainName = L"";
-		m_gamedata->nations[++nation_count] = std::move();
-		
-		std::unique_ptr<Nation> ȫ = std::make_unique<Nation>();
-		ȫ->MainColor = XMFLOAT4(0.5f, 0.0f, 0.0f, 0.75f);
-		ȫ->MainName = L"ȫ";
-		m_gamedata->nations[++nation_count] = std::move(ȫ);
-	}
+	// Ticks come every 100 ms; keep the AI's share bounded however many nations are alive.
+	m_sim->ai.budget_us = 5000;
+	m_sim->LoadNations();
+	mView = &m_sim->Snapshot();
 	//m_gamedata->nations.at(mUser.nationPick)->Ai = false;
 
 
-	draw_mutex.lock();
 	wchar_t buf[256];
-	for (const auto& O : m_gamedata->province)
+	const auto& Prov = m_gamedata->province;
+	for (ProvinceId O : Prov.ids())
 	{
-		if (O.second->p_num)
+		if (Prov.p_num[O])
 		{
-			swprintf_s(buf, LR"(<div id="prov%.0lf" enable="disable" background="enable" opacity="0.5">)", (double)O.first);
+			swprintf_s(buf, LR"(<div id="prov%.0lf" enable="disable" background="enable" opacity="0.5">)", (double)O);
 			auto E = m_DrawItems->Insert(buf);
-			swprintf_s(buf, LR"(<a id="provtext%.0lf" enable="disable" opacity="1.0" color-hex="FFFFFF">)", (double)O.first);
+			swprintf_s(buf, LR"(<a id="provtext%.0lf" enable="disable" opacity="1.0" color-hex="FFFFFF">)", (double)O);
 			m_DrawItems->Insert(buf, E);
 		}
 	}
@@ -1873,139 +891,117 @@ void MyApp::GameInit()
 					
 
 	m_DrawItems->Insert(LR"(<img id="myDiv" src="Cursor" z-index="1e10" left="0" top="0" width="40" height="40" pointer-events="none">)");
-	draw_mutex.unlock();
 	GameLoad(); 
 
 	trdGame = std::async(&MyApp::MainGame, this);
 	//trdGame.join();
 }
 
-std::unordered_map<std::wstring, std::wstring> MyApp::Act(std::wstring func_name, std::initializer_list<std::wstring> args, bool only_test, bool try_lock)
+void MyApp::ClearSelection()
 {
-	std::unordered_map<std::wstring, std::wstring> _Return;
-	std::unordered_map<std::wstring, std::wstring> arg;
-	std::wstring head;
-	for (auto P = args.begin();;)
+	for (LeaderId O : mSelected)
 	{
-		if (P == args.end()) break;
-		head = *(P++);
-		if (P == args.end()) break;
-		arg[head] = *(P++);
-	}
-
-	if (func_name == L"Draft")
-	{	
-		ProvinceId id = std::stoull(arg[L"location"]);
-		auto prov = m_gamedata->province.find(id);
-		std::int64_t draft_size = 1000;
-		NationId owner = 0;
-		bool force = false;
-
-		
-
-		if (arg.find(L"size") != arg.end()) draft_size = Long(arg[L"size"]);
-		if (arg.find(L"owner") != arg.end()) owner = std::stoull(arg[L"owner"]);
-		else if (auto N = m_gamedata->nations.find(prov->second->ruler); N != m_gamedata->nations.end())
-		{
-			owner = N->first;
-			N->second->abb_army_move;
-		}
-		if (arg.find(L"force") != arg.end()) force = true;
-		
-		if (prov->second->man >= draft_size || force)
-		{
-			if (only_test)
+		m_DrawItems->$(L"#leader" + Str(O)).css(
 			{
-				_Return.insert(std::make_pair(L"SUCCESS", L""));
+				L"src", L"Window"
 			}
-			else
-			{
-				if (!force)	prov->second->man -= draft_size;
+		);
+	}
+	mSelected.clear();
+}
 
-				wchar_t buf[256];
-				if (try_lock) draw_mutex.lock();
-				swprintf_s(buf, LR"(<img id="leader%llu" src="Window" enable="disable" pointer-events="none" gamedata-leaderid="%llu">)", m_gamedata->leader_progress, m_gamedata->leader_progress);
-				std::uint64_t EM = m_DrawItems->Insert(buf);
-				std::wstring nation_name = owner > 0 ? m_gamedata->nations.at(owner)->MainName : L"𸣴±";
-				
-				
-				
+void MyApp::PostSelection()
+{
+	m_sim->Post(SelectCommand{ SelectedLeaders() });
+}
 
-				m_DrawItems->Insert(LR"(<div id="background" enable="disable" background-color-r="1" background-color-g="1" background-color-b="1" pointer-events="none" background="enable">)", EM);
-				if (owner)
-				{
-					auto Color = m_gamedata->nations.find(owner)->second->MainColor;
-					swprintf_s(buf, LR"(<div id="progress" enable="disable" background-color-r="%f" background-color-g="%f" background-color-b="%f" pointer-events="none" z-index="1e-4" background="enable">)", Color.x, Color.y, Color.z);
-					m_DrawItems->Insert(buf, EM);
-				}
-				else m_DrawItems->Insert(LR"(<div id="progress" enable="disable" background-color="777777" pointer-events="none" z-index="1e-4" background="enable">)", EM);
-				m_DrawItems->Insert(LR"(<a id="num" text="000" enable="disable" color-r="0" color-g="0" color-b="0" pointer-events="none">)", EM);
-				m_DrawItems->Insert(LR"(<img id="state" src="Window" enable="disable" pointer-events="none">)", EM);
+std::vector<LeaderId> MyApp::SelectedLeaders() const
+{
+	std::vector<LeaderId> ids(mSelected.begin(), mSelected.end());
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
 
-				_Return.insert(std::make_pair(L"leaderid", Str(m_gamedata->leader_progress)));
-				auto L = m_gamedata->NewLeader(id, owner, draft_size);
+void MyApp::GUISyncLeaders()
+{
+	wchar_t buf[256];
+	const auto& V = *mView;
+	for (const auto& O : V.leaders)
+	{
+		if (!mLeaderWidgets.insert(O.id).second)
+			continue;
 
-				if (auto N = m_gamedata->nations.find(prov->second->ruler); N != m_gamedata->nations.end())
-				{
-					L.abb_move = N->second->abb_army_move;
-					L.abb_sieze = N->second->abb_army_sieze;
-					L.abb_disp = N->second->abb_disp;
-				}
+		NationId owner = O.owner;
+		swprintf_s(buf, LR"(<img id="leader%llu" src="Window" enable="disable" pointer-events="none" gamedata-leaderid="%llu">)", O.id, O.id);
+		std::uint64_t EM = m_DrawItems->Insert(buf);
+		std::wstring nation_name = L"𸣴±";
+		if (auto N = m_gamedata->nations.find(owner); N != m_gamedata->nations.end()) nation_name = N->second->MainName;
 
-				if (arg.find(L"abb_move") != arg.end()) L.abb_move = Float(arg[L"abb_move"]);
-				if (arg.find(L"abb_sieze") != arg.end()) L.abb_sieze = Float(arg[L"abb_sieze"]);
-				if (arg.find(L"abb_disp") != arg.end()) L.abb_disp = Float(arg[L"abb_disp"]);
+		m_DrawItems->Insert(LR"(<div id="background" enable="disable" background-color-r="1" background-color-g="1" background-color-b="1" pointer-events="none" background="enable">)", EM);
+		if (auto N = m_gamedata->nations.find(owner); N != m_gamedata->nations.end())
+		{
+			auto Color = N->second->MainColor;
+			swprintf_s(buf, LR"(<div id="progress" enable="disable" background-color-r="%f" background-color-g="%f" background-color-b="%f" pointer-events="none" z-index="1e-4" background="enable">)", Color.x, Color.y, Color.z);
+			m_DrawItems->Insert(buf, EM);
+		}
+		else m_DrawItems->Insert(LR"(<div id="progress" enable="disable" background-color="777777" pointer-events="none" z-index="1e-4" background="enable">)", EM);
+		m_DrawItems->Insert(LR"(<a id="num" text="000" enable="disable" color-r="0" color-g="0" color-b="0" pointer-events="none">)", EM);
+		m_DrawItems->Insert(LR"(<img id="state" src="Window" enable="disable" pointer-events="none">)", EM);
 
-				m_gamedata->leaders.insert(std::make_pair(m_gamedata->leader_progress++, std::make_unique<Leader>(L)));
+		swprintf_s(buf, LR"(<img id="flag" src="%ls" enable="disable" mousedown="SelectLeader">)", nation_name.c_str());
+		m_DrawItems->Insert(buf, EM);
+	}
 
-				if (prov->second->owner == mUser.nationPick || mUser.nationPick == 0)
-					swprintf_s(buf, LR"(<img id="flag" src="%ls" enable="disable" mousedown="SelectLeader">)", nation_name.c_str());
-				else
-					swprintf_s(buf, LR"(<img id="flag" src="%ls" enable="disable" mousedown="SelectLeader">)", nation_name.c_str());
-				
-				m_DrawItems->Insert(buf, EM);
-				if (try_lock) draw_mutex.unlock();
-			}
+	for (auto O = mLeaderWidgets.begin(); O != mLeaderWidgets.end();)
+	{
+		if (V.Find(*O))
+		{
+			++O;
+			continue;
 		}
+
+		for (const auto& E : m_DrawItems->$(L"#leader" + Str(*O) + L" flag")) m_DrawItems->data.erase(E);
+		for (const auto& E : m_DrawItems->$(L"#leader" + Str(*O) + L" state")) m_DrawItems->data.erase(E);
+		for (const auto& E : m_DrawItems->$(L"#leader" + Str(*O) + L" num")) m_DrawItems->data.erase(E);
+		for (const auto& E : m_DrawItems->$(L"#leader" + Str(*O) + L" background")) m_DrawItems->data.erase(E);
+		for (const auto& E : m_DrawItems->$(L"#leader" + Str(*O) + L" progress")) m_DrawItems->data.erase(E);
+		for (const auto& E : m_DrawItems->$(L"#leader" + Str(*O))) m_DrawItems->data.erase(E);
+		mSelected.erase(*O);
+		if (mLastLeader == *O) mLastLeader = 0;
+		O = mLeaderWidgets.erase(O);
 	}
-	return _Return;
 }
 
-
 void MyApp::GUIUpdatePanelLeader(LeaderId leader_id)
 {
 	if (leader_id == 0)
-		leader_id = m_gamedata->last_leader_id;	
+		leader_id = mLastLeader;	
 	else
-		m_gamedata->last_leader_id = leader_id;
-	m_gamedata->last_prov_id = 0;
+		mLastLeader = leader_id;
+	mLastProv = 0;
 	std::wstring nation_name = L"  ";
 	std::wstring present_com = L"  ";
 	std::wstring progress = L"  ";
 	LeaderId leader = leader_id;
 	std::wstring head = L"LeaderId : " + Str(leader_id);
-	if (auto Q = m_gamedata->leaders.find(leader); Q != m_gamedata->leaders.end())
+	if (const auto* Q = mView->Find(leader))
 	{
 		head.resize(256);
-		swprintf_s(head.data(), 256, L"%llu°  %lld", leader_id, Q->second->size);
+		swprintf_s(head.data(), 256, L"%llu°  %lld", leader_id, Q->size);
 
-		if (Q->second->selected)
+		if (mSelected.count(leader))
 		{
-			if (Q->second->cmd.size() > 0)
+			if (Q->orders > 0)
 			{
-				float sum = 0;
-				auto R = Q->second->cmd.cbegin();
-				switch (R->type)
+				switch (Q->order)
 				{
 				case CommandType::Move:
-					present_com = m_gamedata->province.at(R->target_prov)->name + L" ̵";
-					
-					std::for_each(Q->second->cmd.begin(), Q->second->cmd.end(), [&S = sum](std::list<Command>::const_reference O) { S += O.need; });
-					progress = Str((int)Q->second->cmd_pr) + L" / " + Str((int)R->need) + L" : ( " + Str((int)sum) + L")";
+					present_com = m_gamedata->province.name.at(Q->target) + L" ̵";
+					progress = Str((int)Q->progress) + L" / " + Str((int)Q->need) + L" : ( " + Str((int)Q->total_need) + L")";
 					break;
 				case CommandType::Sieze:
-					present_com = m_gamedata->province.at(R->target_prov)->name + L" ";
-					progress = Str((int)Q->second->cmd_pr) + L" / " + Str((int)R->need) + L" ڿ ";
+					present_com = m_gamedata->province.name.at(Q->target) + L" ";
+					progress = Str((int)Q->progress) + L" / " + Str((int)Q->need) + L" ڿ ";
 					break;
 				}
 
@@ -2015,7 +1011,7 @@ void MyApp::GUIUpdatePanelLeader(LeaderId leader_id)
 				present_com = L" ";
 			}
 		}
-		if (auto R = m_gamedata->nations.find(Q->second->owner); R != m_gamedata->nations.end())
+		if (auto R = m_gamedata->nations.find(Q->owner); R != m_gamedata->nations.end())
 		{
 			nation_name = R->second->MainName;
 		}
@@ -2070,16 +1066,20 @@ void MyApp::GUIUpdatePanelLeader(LeaderId leader_id)
 void MyApp::GUIUpdatePanelProvince(ProvinceId prov_id)
 {
 	if (prov_id == 0)
-		prov_id = m_gamedata->last_prov_id;
+		prov_id = mLastProv;
 	else
-		m_gamedata->last_prov_id = prov_id;
-	m_gamedata->last_leader_id = 0;
-
-	std::map<ProvinceId, std::unique_ptr<Province>>::iterator prov = m_gamedata->province.find(prov_id);
-	if (prov == m_gamedata->province.end())
+		mLastProv = prov_id;
+	mLastLeader = 0;
+
+	// Only the snapshot and the map data LoadMap fixed are read here.  The draft button
+	// goes by the published draftable flag, and the posted DraftRequest is checked
+	// again when Step applies it.
+	const auto& Prov = m_gamedata->province;
+	const auto& V = *mView;
+	if (!Prov.contains(prov_id) || !V.Contains(prov_id))
 		return;
 
-	const auto N = m_gamedata->nations.find(prov->second->owner);
+	const auto N = m_gamedata->nations.find(V.owner[prov_id]);
 	std::wstring nation_name = N == m_gamedata->nations.end() ? L"𸣴±" : N->second->MainName;
 
 	m_DrawItems->$(L".myForm").css(
@@ -2096,15 +1096,15 @@ void MyApp::GUIUpdatePanelProvince(ProvinceId prov_id)
 		});
 	m_DrawItems->$(L".myForm #textContainer text2").css(
 		{
-			L"text", L" : " + Str(prov->second->man)
+			L"text", L" : " + Str(V.man[prov_id])
 		});
 	m_DrawItems->$(L".myForm #textContainer text3").css(
 		{
-			L"text", L"/" + Str(prov->second->maxman)
+			L"text", L"/" + Str(V.maxman[prov_id])
 		});
 	m_DrawItems->$(L".myForm #head").css(
 		{
-			L"text", prov->second->name + L":" + Str(prov->first)
+			L"text", Prov.name[prov_id] + L":" + Str(prov_id)
 		});
 	m_DrawItems->$(L".myForm #tail").css(
 		{
@@ -2112,9 +1112,9 @@ void MyApp::GUIUpdatePanelProvince(ProvinceId prov_id)
 		});
 	m_DrawItems->$(L".myForm #textContainer text1").css(
 		{
-			L"text", L"HP " + Str(prov->second->hp) + L" / " + Str(prov->second->p_num)
+			L"text", L"HP " + Str(V.hp[prov_id]) + L" / " + Str(Prov.p_num[prov_id])
 		});
-	if (auto X = Act(L"Draft", {L"location", Str(prov->first)}, true); X.find(L"SUCCESS") != X.end() && (prov->second->ruler == mUser.nationPick || mUser.nationPick == 0))
+	if (V.draftable[prov_id] && (V.ruler[prov_id] == mUser.nationPick || mUser.nationPick == 0))
 	{
 		m_DrawItems->$(L".myForm #buttonbar button0").css(
 			{
@@ -2172,49 +1172,36 @@ void MyApp::Execute(const std::wstring& func_name, const std::uint64_t& uuid)
 		}
 		else if (func_name == L"DraftForP3")
 		{
-			Act(L"Draft", {L"location", (**m_DrawItems->$(Str(uuid) + L" .. .. ..").begin())[L"gamedata-provinceid"]});
+			m_sim->Post(DraftRequest::At(std::stoull((**m_DrawItems->$(Str(uuid) + L" .. .. ..").begin())[L"gamedata-provinceid"])));
 			
 		}
 		else if (func_name == L"SelectLeader")
 		{
 			game_contype = GameControlType::Leader;
 			auto P = (*m_DrawItems->$(Str(uuid) + L" ..").begin());
-			bool is_select = false;
 			LeaderId leader = std::stoull((*P)[L"gamedata-leaderid"]);
+			bool is_select = !mSelected.count(leader);
 			
-			for (auto& Q : m_gamedata->leaders)
+			if (!GetAsyncKeyState(VK_LCONTROL)) ClearSelection();
+			else mSelected.erase(leader);
+			if (is_select)
 			{
-				if (Q.first == leader)
-				{
-					Q.second->selected = !Q.second->selected;
-					if (Q.second->selected)
+				mSelected.insert(leader);
+				m_DrawItems->$(L"#leader" + Str(leader)).css(
 					{
-						m_DrawItems->$(L"#leader" + Str(Q.first)).css(
-							{
-								L"src", L"WindowHighlight"
-							}
-						);
-						is_select = true;
+						L"src", L"WindowHighlight"
 					}
-					else
+				);
+			}
+			else
+			{
+				m_DrawItems->$(L"#leader" + Str(leader)).css(
 					{
-						m_DrawItems->$(L"#leader" + Str(Q.first)).css(
-							{
-								L"src", L"Window"
-							}
-						);
+						L"src", L"Window"
 					}
-				}
-				else if (Q.second->selected && !GetAsyncKeyState(VK_LCONTROL))
-				{
-					m_DrawItems->$(L"#leader" + Str(Q.first)).css(
-						{
-							L"src", L"Window"
-						}
-					);
-					Q.second->selected = false;
-				}
+				);
 			}
+			PostSelection();
 
 			if (is_select)
 			{
@@ -2228,170 +1215,172 @@ void MyApp::Execute(const std::wstring& func_name, const std::uint64_t& uuid)
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"糪") { owner = N.first; break; };
 
-			Act(L"Draft", { L"location", L"20", L"size", L"25000", L"owner", Str(owner), L"force", L"" });
-			Act(L"Draft", { L"location", L"21", L"size", L"25000", L"owner", Str(owner), L"force", L"" });
+			m_sim->Post(DraftRequest::At(20).Size(25000).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(21).Size(25000).Owner(owner).Forced());
 		}
 		else if (func_name == L"button1") //Magal Invasion
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
 
-			draw_mutex.lock();
-			Act(L"Draft", { L"location", L"16", L"size", L"3500", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"16", L"size", L"2500", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"16", L"size", L"1500", L"owner", Str(owner), L"force", L"" }, false, false);
-			draw_mutex.unlock();
+			m_sim->Post(DraftRequest::At(16).Size(3500).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(16).Size(2500).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(16).Size(1500).Owner(owner).Forced());
 		}
 		else if (func_name == L"button2") //We Invasion
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
 
-			draw_mutex.lock();
-			Act(L"Draft", { L"location", L"19", L"size", L"11000", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"2", L"size", L"1100", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"3", L"size", L"1100", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"4", L"size", L"1100", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"7", L"size", L"1100", L"owner", Str(owner), L"force", L"" }, false, false);
-			draw_mutex.unlock();
+			m_sim->Post(DraftRequest::At(19).Size(11000).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(2).Size(1100).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(3).Size(1100).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(4).Size(1100).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(7).Size(1100).Owner(owner).Forced());
 		}
 		else if (func_name == L"button3") //Yuan Invasion
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			draw_mutex.lock();
 			for (int i = 0; i < 3; i++)
 			{
-				Act(L"Draft", { L"location", L"26", L"size", L"12000", L"owner", Str(owner), L"force", L"", L"abb_sieze", L"4", L"abb_move", L"3" }, false, false);
+				m_sim->Post(DraftRequest::At(26).Size(12000).Owner(owner).Forced().Sieze(4.f).Move(3.f));
 			}
-			draw_mutex.unlock();
 		}
 		else if (func_name == L"button4") //Joseon Revolt
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
 
-			Act(L"Draft", { L"location", L"12", L"size", L"33000", L"owner", Str(owner), L"force", L"", L"abb_sieze", L"2" });
+			m_sim->Post(DraftRequest::At(12).Size(33000).Owner(owner).Forced().Sieze(2.f));
 		}
 		else if (func_name == L"button5") //Goryeo Revolt
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
 
-			draw_mutex.lock();
 			for (int i = 0; i < 3; i++)
 			{
-				Act(L"Draft", { L"location", L"7", L"size", L"15000", L"owner", Str(owner), L"force", L"", L"abb_move", L"2" }, false, false);
+				m_sim->Post(DraftRequest::At(7).Size(15000).Owner(owner).Forced().Move(2.f));
 			}
-			draw_mutex.unlock();
 		}
 		else if (func_name == L"button6") //Gaya Revolt
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
 
-			Act(L"Draft", { L"location", L"3", L"size", L"7000", L"owner", Str(owner), L"force", L"" });
+			m_sim->Post(DraftRequest::At(3).Size(7000).Owner(owner).Forced());
 		}
 		else if (func_name == L"button7") //Balhae Revolt
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
 
-			Act(L"Draft", { L"location", L"15", L"size", L"14000", L"owner", Str(owner), L"force", L"" });
+			m_sim->Post(DraftRequest::At(15).Size(14000).Owner(owner).Forced());
 		}
 		else if (func_name == L"button8") //Balhae Revolt
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"ѱ") { owner = N.first; break; };
 
-			draw_mutex.lock();
-			Act(L"Draft", { L"location", L"2", L"size",  L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"3", L"size",  L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"4", L"size",  L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"5", L"size",  L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"6", L"size",  L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"7", L"size",  L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"8", L"size",  L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"9", L"size",  L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"10", L"size", L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"11", L"size", L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"12", L"size", L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"13", L"size", L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"14", L"size", L"3333", L"owner", Str(owner), L"force", L"" }, false, false);
-			draw_mutex.unlock();
+			m_sim->Post(DraftRequest::At(2).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(3).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(4).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(5).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(6).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(7).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(8).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(9).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(10).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(11).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(12).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(13).Size(3333).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(14).Size(3333).Owner(owner).Forced());
 		}
 		else if (func_name == L"button9") //Balhae Revolt
 		{
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
 
-			Act(L"Draft", { L"location", L"9", L"size", L"30000", L"owner", Str(owner), L"force", L"" });
+			m_sim->Post(DraftRequest::At(9).Size(30000).Owner(owner).Forced());
 		}
 		else if (func_name == L"button10") //State Age
 		{
-			draw_mutex.lock();
 			NationId owner = 0;
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"Ŷ") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"25", L"size", L"30000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(25).Size(30000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"θ") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"17", L"size", L"9000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(17).Size(9000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"ο") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"15", L"size", L"10000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(15).Size(10000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"ο") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"18", L"size", L"18000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(18).Size(18000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"13", L"size", L"16000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(13).Size(16000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"12", L"size", L"8000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(12).Size(8000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"14", L"size", L"9000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(14).Size(9000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"º") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"10", L"size", L"20000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(10).Size(20000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"11", L"size", L"10000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(11).Size(10000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"7", L"size", L"10000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(7).Size(10000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"9", L"size", L"12000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(9).Size(12000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"5", L"size", L"32000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(5).Size(32000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"2", L"size", L"13000", L"owner", Str(owner), L"forȫce", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(2).Size(13000).Owner(owner));
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"4", L"size", L"11000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(4).Size(11000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"3", L"size", L"9000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(3).Size(9000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"Ž") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"1", L"size", L"8000", L"owner", Str(owner), L"force", L"" }, false, false);
+			m_sim->Post(DraftRequest::At(1).Size(8000).Owner(owner).Forced());
 
 			for (auto& N : m_gamedata->nations) if (N.second->MainName == L"ȫ") { owner = N.first; break; };
-			Act(L"Draft", { L"location", L"22", L"size", L"60000", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"22", L"size", L"60000", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"22", L"size", L"60000", L"owner", Str(owner), L"force", L"" }, false, false);
-			Act(L"Draft", { L"location", L"22", L"size", L"60000", L"owner", Str(owner), L"force", L"" }, false, false);
-			draw_mutex.unlock();
+			m_sim->Post(DraftRequest::At(22).Size(60000).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(22).Size(60000).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(22).Size(60000).Owner(owner).Forced());
+			m_sim->Post(DraftRequest::At(22).Size(60000).Owner(owner).Forced());
 		}
 	}
 }
 
 void MyApp::GameUpdate()
 {
-	draw_mutex.lock();
+	mView = &m_sim->Snapshot();
+	GUISyncLeaders();
+	if (mTicked.exchange(false) && mLastProv > 0)
+	{
+		GUIUpdatePanelProvince();
+	}
+	if (mLeadersChanged.exchange(false))
+	{
+		UpdateArrow();
+		GUIUpdatePanelLeader();
+	}
+	if (mSaved.exchange(false))
+	{
+		captions[L" "] = L"";
+	}
 	if (auto N = m_gamedata->nations.find(mUser.nationPick); N != m_gamedata->nations.end())
 	{
 		m_DrawItems->$(L"#myNationFlag").css({
@@ -2423,30 +1412,20 @@ void MyApp::GameUpdate()
 	
 
 	XMFLOAT4 rgb;
-	std::list<decltype(m_gamedata->leaders)::value_type> itr_buf;
-	for (const auto& O : m_gamedata->province)
+	const auto& Prov = m_gamedata->province;
+	const auto& V = *mView;
+	for (ProvinceId O : Prov.ids())
 	{
-		if (!O.second->p_num)
+		if (!Prov.p_num[O] || !V.Contains(O))
 		{
 			continue;
 		}
-		rgb = XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-		mMainPassCB.gSubProv[O.first] = XMFLOAT4(0.f, 0.f, 0.f, 0.f);
-		mMainPassCB.gProv[O.first] = { 0.f,0.f,0.f,0.f };
-
-		if (const auto& P = m_gamedata->nations.find(O.second->owner); P != m_gamedata->nations.end())
-		{
-			rgb = P->second->MainColor;
-			mMainPassCB.gProv[O.first] = P->second->MainColor;
-			mMainPassCB.gSubProv[O.first] = P->second->MainColor;
-		}
-		if (const auto& P = m_gamedata->nations.find(O.second->ruler); P != m_gamedata->nations.end())
-		{
-			mMainPassCB.gSubProv[O.first] = P->second->MainColor;
-		}
+		rgb = ToXM(V.owner_color[O]);
+		mMainPassCB.gProv[O] = rgb;
+		mMainPassCB.gSubProv[O] = m_gamedata->nations.count(V.ruler[O]) ? ToXM(V.ruler_color[O]) : rgb;
 
 
-		XMFLOAT3 pos = O.second->on3Dpos;
+		XMFLOAT3 pos = ToXM(Prov.on3Dpos[O]);
 		pos.x /= 2.f;
 		pos.y /= 2.f;
 		pos.z /= 2.f;
@@ -2455,7 +1434,7 @@ void MyApp::GameUpdate()
 		pos.y -= 3.f;
 		XMFLOAT3 s2 = Convert3Dto2D(XMLoadFloat3(&pos));
 
-		float w = mClientHeight / 20.f * O.second->name.length() + 10.f;
+		float w = mClientHeight / 20.f * Prov.name[O].length() + 10.f;
 		float h = mClientHeight / 15.f;
 		float size = 25.0f / s.z;
 		float depth = (s.z - 1.f) / (1000.f - 1.f);
@@ -2463,7 +1442,7 @@ void MyApp::GameUpdate()
 		{
 			w *= size;
 			h *= size;
-			m_DrawItems->$(L"#prov" + Str(O.first)).css(
+			m_DrawItems->$(L"#prov" + Str(O)).css(
 				{
 					L"background-color-r", Str(rgb.x / 1.5f),
 					L"background-color-g", Str(rgb.y / 1.5f),
@@ -2479,12 +1458,12 @@ void MyApp::GameUpdate()
 					L"vertical-align", L"center"
 				}
 			);
-			m_DrawItems->$(L"#provtext" + Str(O.first)).css(
+			m_DrawItems->$(L"#provtext" + Str(O)).css(
 				{
 					L"enable", L"enable",
 					L"width", Str(w),
 					L"height", Str(h),
-					L"text", O.second->name,// + L" " + */Str(O.first) ,
+					L"text", Prov.name[O],// + L" " + */Str(O) ,
 					L"z-index", Str(1 - depth + 1e-6),
 					L"horizontal-align", L"center",
 					L"vertical-align", L"center"
@@ -2493,37 +1472,32 @@ void MyApp::GameUpdate()
 		}
 		else
 		{
-			m_DrawItems->$(L"#prov" + Str(O.first)).css(
+			m_DrawItems->$(L"#prov" + Str(O)).css(
 				{
 					L"enable", L"disable"
 				}
 			);
 
-			m_DrawItems->$(L"#provtext" + Str(O.first)).css(
+			m_DrawItems->$(L"#provtext" + Str(O)).css(
 				{
 					L"enable", L"disable"
 				}
 			);
 		}
 
-		itr_buf.clear();
-		for (const auto& P : m_gamedata->leaders)
-		{
-			if (P.second->location == O.first)
-			{
-				itr_buf.push_back(P);
-			}
-		}
+		const std::uint32_t first = V.AtBegin(O), last = V.AtEnd(O);
 
 		std::uint64_t  i = 0;
-		for (const auto& P : itr_buf)
+		for (std::uint32_t k = first; k < last; ++k)
 		{
+			const auto& P = V.leaders[k];
+			const LeaderId l = P.id;
 			if (s.z >= 1.f && s.z <= 1000.0f)
 			{
-				m_DrawItems->$(L"#leader" + Str(P.first)).css(
+				m_DrawItems->$(L"#leader" + Str(l)).css(
 					{
 						L"enable", L"enable",
-						L"left", Str(s.x + (i - (itr_buf.size() - 1.f) / 2) * size * 100.f),
+						L"left", Str(s.x + (i - (last - first - 1.f) / 2) * size * 100.f),
 						L"top",Str(s.y + size * 135.f),
 						L"width", Str(size * 95.f),
 						L"height",Str(size * 95.f),
@@ -2532,7 +1506,7 @@ void MyApp::GameUpdate()
 						L"vertical-align", L"center"
 					}
 				);
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" flag").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" flag").css(
 					{
 						L"enable", L"enable",
 						L"width", Str(size * 95.f / 32 * 26),
@@ -2544,9 +1518,9 @@ void MyApp::GameUpdate()
 				);
 				std::wstring state = L"";
 
-				if (P.second->cmd.size() > 0)
+				if (P.orders > 0)
 				{
-					switch (P.second->cmd.begin()->type)
+					switch (P.order)
 					{
 					case CommandType::Move:
 						state = L"Leader-move";
@@ -2562,7 +1536,7 @@ void MyApp::GameUpdate()
 
 
 
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" state").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" state").css(
 					{
 						L"src", state,
 						L"enable", state == L"" ? L"disable" : L"enable",
@@ -2573,9 +1547,9 @@ void MyApp::GameUpdate()
 						L"vertical-align", L"center"
 					}
 				);
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" num").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" num").css(
 					{
-						L"text", Str(P.second->size),
+						L"text", Str(P.size),
 						L"enable", L"enable",
 						L"width", Str(size * 95.f / 32 * 26),
 						L"top", Str(size * 95.f / 32 * 26 * 2 / 3),
@@ -2585,7 +1559,7 @@ void MyApp::GameUpdate()
 						L"vertical-align", L"top"
 					}
 				);
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" background").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" background").css(
 					{
 						L"enable", L"enable",
 						L"left", Str(-size * 95.f / 32 * 13),
@@ -2598,13 +1572,13 @@ void MyApp::GameUpdate()
 					}
 				);
 
-				if (P.second->cmd.size() > 0)
+				if (P.orders > 0)
 				{
-					m_DrawItems->$(L"#leader" + Str(P.first) + L" progress").css(
+					m_DrawItems->$(L"#leader" + Str(l) + L" progress").css(
 						{
 							L"enable", L"enable",
 							L"left", Str(-size * 95.f / 32 * 13),
-							L"width", Str(size * 95.f / 32 * 26 * (P.second->cmd_pr / P.second->cmd.begin()->need)),
+							L"width", Str(size * 95.f / 32 * 26 * (P.progress / P.need)),
 							L"top", Str(size * 95.f / 32 * 26 * 1 / 3),
 							L"height",Str(size * 95.f / 32 * 26 / 4),
 							L"z-index", Str(2 - depth),
@@ -2615,7 +1589,7 @@ void MyApp::GameUpdate()
 				}
 				else
 				{
-					m_DrawItems->$(L"#leader" + Str(P.first) + L" progress").css(
+					m_DrawItems->$(L"#leader" + Str(l) + L" progress").css(
 						{
 							L"enable", L"enable",
 							L"left", Str(-size * 95.f / 32 * 13),
@@ -2632,32 +1606,32 @@ void MyApp::GameUpdate()
 			}
 			else
 			{
-				m_DrawItems->$(L"#leader" + Str(P.first)).css(
+				m_DrawItems->$(L"#leader" + Str(l)).css(
 					{
 						L"enable", L"disable"
 					}
 				);
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" flag").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" flag").css(
 					{
 						L"enable", L"disable"
 					}
 				);
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" state").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" state").css(
 					{
 						L"enable", L"disable"
 					}
 				);
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" num").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" num").css(
 					{
 						L"enable", L"disable"
 					}
 				);
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" background").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" background").css(
 					{
 						L"enable", L"disable"
 					}
 				);
-				m_DrawItems->$(L"#leader" + Str(P.first) + L" progress").css(
+				m_DrawItems->$(L"#leader" + Str(l) + L" progress").css(
 					{
 						L"enable", L"disable"
 					}
@@ -2702,7 +1676,6 @@ void MyApp::GameUpdate()
 			O[L"inherit-z-index"] = L"0";
 		}
 	}
-	draw_mutex.unlock();
 
 	mEyetarget.m128_f32[0] += mEyeMoveX;
 	mEyetarget.m128_f32[2] += mEyeMoveZ;
@@ -2734,13 +1707,13 @@ void MyApp::InsertArrow(const ProvinceId& start, ProvincePath& path, bool clear)
 	
 	if (path.path.size() == 0) return;
 
-	auto S = m_gamedata->province.at(start)->on3Dpos;
-	auto E = m_gamedata->province.at(*path.path.rbegin())->on3Dpos;
+	auto S = m_gamedata->province.on3Dpos.at(start);
+	auto E = m_gamedata->province.on3Dpos.at(*path.path.rbegin());
 
 	buf0.push_back({ S.x / 2, S.y / 2 + 1.f, S.z / 2 });
 	for (auto Q : path)
 	{
-		auto pos = m_gamedata->province.at(Q)->on3Dpos;
+		auto pos = m_gamedata->province.on3Dpos.at(Q);
 		buf0.push_back({ pos.x / 2, pos.y / 2 + 1.f, pos.z / 2 });
 	}
 	
@@ -2817,52 +1790,33 @@ void MyApp::UpdateArrow()
 {
 	mArrows.vertices.clear();
 	mArrows.indices.clear();
-	for (auto& Q : m_gamedata->leaders)
+	for (LeaderId id : mSelected)
 	{
-		if (Q.second->selected)
+		if (const auto* Q = mView->Find(id))
 		{
-			ProvinceId lastLoc = Q.second->location;
 			ProvincePath path;
-
-			for (auto C : Q.second->cmd)
-			{
-				if (C.type == CommandType::Move)
-				{
-					lastLoc = C.target_prov;
-					path.path.push_back(lastLoc);
-				}
-			}
-			InsertArrow(Q.second->location, path, false);
+			path.path.assign(mView->route.begin() + Q->route_begin, mView->route.begin() + Q->route_end);
+			InsertArrow(Q->location, path, false);
 		}
 	}
 }
 
 void MyApp::ProvinceMousedown(WPARAM btnState, ProvinceId id)
 {
-	auto prov = m_gamedata->province.find(id);
-	if (prov == m_gamedata->province.end())
+	const auto& Prov = m_gamedata->province;
+	if (!Prov.contains(id))
 	{
 		if (btnState & MK_LBUTTON)
 		{
 			mArrows.vertices.clear();
 			mArrows.indices.clear();
-			for (auto& O : m_gamedata->leaders)
-			{
-				if (O.second->selected)
-				{
-					m_DrawItems->$(L"#leader" + Str(O.first)).css(
-						{
-							L"src", L"Window"
-						}
-					);
-					O.second->selected = false;
-				}
-			}
+			ClearSelection();
+			PostSelection();
 			game_contype = GameControlType::View;
 		}
 		else if (btnState & MK_RBUTTON)
 		{
-			if (m_gamedata->last_leader_id > 0)
+			if (mLastLeader > 0)
 			{
 				game_contype = GameControlType::Leader;
 			}
@@ -2870,84 +1824,46 @@ void MyApp::ProvinceMousedown(WPARAM btnState, ProvinceId id)
 		return;
 	}
 	captions[L" κ"] = std::to_wstring(id);
-	captions[L" κ.x"] = std::to_wstring(2.f * prov->second->on3Dpos.x / prov->second->p_num);
-	captions[L" κ.z"] = std::to_wstring(2.f * prov->second->on3Dpos.z / prov->second->p_num);
+	captions[L" κ.x"] = std::to_wstring(2.f * Prov.on3Dpos[id].x / Prov.p_num[id]);
+	captions[L" κ.z"] = std::to_wstring(2.f * Prov.on3Dpos[id].z / Prov.p_num[id]);
 
 
 
 	if (btnState & MK_LBUTTON)
 	{
-		/*prov->second->owner = mUser.nationPick;
-		prov->second->ruler = mUser.nationPick;*/
+		/*Prov.owner[id] = mUser.nationPick;
+		Prov.ruler[id] = mUser.nationPick;*/
 
 		mArrows.vertices.clear();
 		mArrows.indices.clear();
-		for (auto& O : m_gamedata->leaders)
-		{
-			if (O.second->selected)
-			{
-				m_DrawItems->$(L"#leader" + Str(O.first)).css(
-					{
-						L"src", L"Window"
-					}
-				);
-				O.second->selected = false;
-			}
-		}
+		ClearSelection();
+		PostSelection();
 		GUIUpdatePanelProvince(id);
 		game_contype = GameControlType::View;
 	}
 	else if (btnState & MK_RBUTTON)
 	{
-		if (m_gamedata->last_leader_id > 0)
+		if (mLastLeader > 0)
 		{
 			game_contype = GameControlType::Leader;
-			mArrows.vertices.clear();
-			mArrows.indices.clear();
-			for (auto& O : m_gamedata->leaders)
-			{
-				if (O.second->selected)
-				{
-					if (O.second->location == id)
-					{
-						O.second->cmd_pr = 0;
-						O.second->cmd.clear();
-					}
-					else
-					{
-						auto path = ProvincePath(m_gamedata->province, m_gamedata->province_connect, O.second->location, id);
 
-						if (path.path.size() > 0)
-						{
-							O.second->cmd_pr = 0;
-							O.second->cmd.clear();
-							ProvinceId lastLoc = O.second->location;
-							for (auto P : path)
-							{
-								O.second->cmd.push_back(Command(CommandType::Move, P, 0, m_gamedata->province_connect.at(std::make_pair(lastLoc, P))));
-								lastLoc = P;
-							}
-						}
-					}
-					
-				}
-			}
+			// The arrows follow once the move is carried out on the next tick.
+			m_sim->Post(MoveCommand{ SelectedLeaders(), id });
 			GUIUpdatePanelLeader();
-			UpdateArrow();
 		}
 	}
 	else if (btnState & MK_MBUTTON)
 	{
-		if (mUser.nationPick > 0) m_gamedata->nations.at(mUser.nationPick)->Ai = true;
+		if (mUser.nationPick > 0) m_sim->Post(AiCommand{ mUser.nationPick, true });
 		
 
-		mUser.nationPick = prov->second->ruler;
-		if (mUser.nationPick > 0) m_gamedata->nations.at(mUser.nationPick)->Ai = false;
+		mUser.nationPick = mView->Contains(id) ? mView->ruler[id] : 0;
+		if (mUser.nationPick > 0) m_sim->Post(AiCommand{ mUser.nationPick, false });
 		/*else {
 			auto I = m_gamedata->nations.begin();
 			for (int i = 0; i < rand() % m_gamedata->nations.size(); ++i) ++I;
-			prov->second->owner = I->first;
-			prov->second->ruler = I->first;
+			Prov.owner[id] = I->first;
+			Prov.ruler[id] = I->first;
 			
 		}*/
 	}
@@ -2983,19 +1899,15 @@ void MyApp::OnKeyDown(WPARAM btnState)
 
 		if (keyState.at('E'))
 		{
-			for (auto& P : m_gamedata->leaders)
+			if (auto P = mSelected.begin(); P != mSelected.end())
 			{
-				if (P.second->selected)
-				{
-					P.second->selected = false;
-
-					m_DrawItems->$(L"#leader" + Str(P.first)).css(
-						{
-							L"src", L"Window"
-						}
-					);
-					break;
-				}
+				m_DrawItems->$(L"#leader" + Str(*P)).css(
+					{
+						L"src", L"Window"
+					}
+				);
+				mSelected.erase(P);
+				PostSelection();
 			}
 			GUIUpdatePanelLeader();
 			UpdateArrow();			
@@ -3410,35 +2322,22 @@ void MyApp::OnMouseUp(WPARAM btnState, int x, int y)
 		dragtype = DragType::None;
 		break;
 	case DragType::Leader:
-		if (!GetAsyncKeyState(VK_LCONTROL))
-		{
-			for (auto& L : m_gamedata->leaders)
-			{
-				if (L.second->selected)
-				{
-					m_DrawItems->$(L"#leader" + Str(L.first)).css(
-						{
-							L"src", L"Window"
-						}
-					);
-					L.second->selected = false;
-				}
-			}
-		}
-		for (const auto& O : m_gamedata->province)
+		if (!GetAsyncKeyState(VK_LCONTROL)) ClearSelection();
+		const auto& Prov = m_gamedata->province;
+		for (ProvinceId O : Prov.ids())
 		{
-			if (!O.second->p_num)
+			if (!Prov.p_num[O])
 			{
 				continue;
 			}
 
-			XMFLOAT3 pos = O.second->on3Dpos;
+			XMFLOAT3 pos = ToXM(Prov.on3Dpos[O]);
 			pos.x /= 2.f;
 			pos.y /= 2.f;
 			pos.z /= 2.f;
 			XMFLOAT3 s = Convert3Dto2D(XMLoadFloat3(&pos));
 
-			float w = mClientHeight / 20.f * O.second->name.length() + 10.f;
+			float w = mClientHeight / 20.f * Prov.name[O].length() + 10.f;
 			float h = mClientHeight / 15.f;
 			float size = 25.0f / s.z;
 			float depth = (s.z - 1.f) / (1000.f - 1.f);
@@ -3446,23 +2345,25 @@ void MyApp::OnMouseUp(WPARAM btnState, int x, int y)
 			{
 				if (Draw_rect.left <= s.x && s.x <= Draw_rect.right && Draw_rect.top <= s.y && s.y <= Draw_rect.bottom)
 				{
-					for (auto& L : m_gamedata->leaders)
+					for (std::uint32_t k = mView->AtBegin(O); k < mView->AtEnd(O); ++k)
 					{
-						if (L.second->location == O.first && (L.second->owner == mUser.nationPick || mUser.nationPick == 0))
+						const LeaderId l = mView->leaders[k].id;
+						if (mView->leaders[k].owner == mUser.nationPick || mUser.nationPick == 0)
 						{
-							m_DrawItems->$(L"#leader" + Str(L.first)).css(
+							m_DrawItems->$(L"#leader" + Str(l)).css(
 								{
 									L"src", L"WindowHighlight"
 								}
 							);
-							L.second->selected = true;
+							mSelected.insert(l);
 							flag = true;
-							m_gamedata->last_leader_id = L.first;
+							mLastLeader = l;
 						}
 					}
 				}
 			}
 		}
+		PostSelection();
 		if (flag) { GUIUpdatePanelLeader(); game_contype = GameControlType::Leader; };
 		dragtype = DragType::None;
 		break;
@@ -3479,7 +2380,6 @@ void MyApp::OnMouseUp(WPARAM btnState, int x, int y)
 
 std::list<YTML::DrawItem>::reverse_iterator MyApp::MouseOnUI(int x, int y)
 {
-	draw_mutex.lock();
 	for (auto O = m_DrawItems->data.rbegin(); O != m_DrawItems->data.rend(); ++O)
 	{
 		if (!O->enable || (*O)[L"pointer-events"] == L"none")
@@ -3528,11 +2428,9 @@ std::list<YTML::DrawItem>::reverse_iterator MyApp::MouseOnUI(int x, int y)
 		if (Draw_rect.left <= x && Draw_rect.right >= x &&
 			Draw_rect.top <= y && Draw_rect.bottom >= y)
 		{
-			draw_mutex.unlock();
 			return O;
 		}
 	}
-	draw_mutex.unlock();
 	return m_DrawItems->data.rend();
 }
 
@@ -3940,35 +2838,7 @@ void MyApp::BuildLandGeometry()
 	std::ifstream prov_file("Map/prov.bmp", std::ios::binary);
 	assert(file && prov_file && prov_list);
 	{
-		std::map<Color32, std::pair<ProvinceId, std::wstring>> prov_key;
-
-		{
-			std::wstring name, index, r, g, b;
-			for (std::wstring line; std::getline(prov_list, line); )
-			{
-				for (size_t i = 0; i < line.size(); ++i)
-				{
-					if (line.at(i) == ' ')
-					{
-						line.erase(i--, 1);
-						continue;
-					}
-				}
-				name = line.substr(0, line.find('/'));
-				line.erase(0, line.find('/') + 1);
-				index = line.substr(0, line.find('='));
-				line.erase(0, line.find('=') + 1);
-				r = line.substr(0, line.find(','));
-				line.erase(0, line.find(',') + 1);
-				g = line.substr(0, line.find(','));
-				line.erase(0, line.find(',') + 1);
-				b = line;
-
-				//OutputDebugStringA((index + "::(" + r + ", " + g + ", " + b + ")\n").c_str());
-
-				prov_key.insert(std::make_pair(rgb2dex(std::stoi(r), std::stoi(g), std::stoi(b)), std::make_pair(std::stoi(index), name)));
-			}
-		}
+		std::wstring prov_text((std::istreambuf_iterator<wchar_t>(prov_list)), std::istreambuf_iterator<wchar_t>());
 
 		file.seekg(0, std::ios::end);
 		std::streampos length = file.tellg();
@@ -3989,19 +2859,23 @@ void MyApp::BuildLandGeometry()
 
 
 		OutputDebugStringA(("File Length : " + std::to_string(length) + "\n").c_str());
-		
+
+		m_sim->LoadMap(prov_text, buf, prov_buf);
+		// Maps too large for the table get the hierarchy instead.
+		if (!m_sim->PrepareDistances("Map/path.cache")) m_sim->PrepareHierarchy("Map/path.ch");
+		for (const auto& line : m_sim->log)
+			OutputDebugStringA((line + "\n").c_str());
+		m_sim->log.clear();
 
 		//B-G-R
 
-		size_t w = (((((int)buf[21] * 256) + buf[20]) * 256) + buf[19]) * 256 + buf[18];
-		size_t h = (((((int)buf[25] * 256) + buf[24]) * 256) + buf[23]) * 256 + buf[22];
+		size_t w = m_gamedata->map_w;
+		size_t h = m_gamedata->map_h;
 
 		map_w = w;
 		map_h = h;
 
-		OutputDebugStringA(("Map Size(w, h) = (" + std::to_string(w) + ", " + std::to_string(h) + ")\n").c_str());
 		mLandVertices.resize(w * h);
-		std::unordered_map<Color32, std::pair<XMUINT3, size_t>> unregisted_color;
 
 		XMFLOAT3 vMinf3(+MathHelper::Infinity, +MathHelper::Infinity, +MathHelper::Infinity);
 		XMFLOAT3 vMaxf3(-MathHelper::Infinity, -MathHelper::Infinity, -MathHelper::Infinity);
@@ -4009,18 +2883,12 @@ void MyApp::BuildLandGeometry()
 		XMVECTOR vMin = XMLoadFloat3(&vMinf3);
 		XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
 
-		Color32 ind;
 		unsigned int r, g, b;
-		float R0, G0, B0, R1, G1, B1, syc;
-		size_t addr, naddr;
-		Color32 dex, ndex;
+		size_t addr;
 		mWaves = std::make_unique<Waves>(map_h / 3, map_w / 3, 3.0f, 0.03f, 4.0f, 0.2f);
-		size_t nx, ny;
-		int W[4][2] = { {1 , 0}, {0, -1}, {-1, 0}, {0, 1} };
 
 		for (size_t y = h - 1;; --y) {
 			for (size_t x = 0; x < w; ++x) {
-				//OutputDebugStringA((std::to_string(x) + ", " + std::to_string(y) + "\n").c_str());
 				addr = 54 + (x + (y * w)) * 3;
 				r = buf[addr + 0];
 				g = buf[addr + 1];
@@ -4037,79 +2905,13 @@ void MyApp::BuildLandGeometry()
 				//mWaves->mPrevSolution[x + (h - 1 - y) * w].earth = mLandVertices[x + y * w].Pos.y;
 
 				mLandVertices[x + y * w].TexC = { 1.f / (w - 1) * x, 1.f / (h - 1) * y };
-				mLandVertices[x + y * w].Prov = 0;
+				mLandVertices[x + y * w].Prov = m_gamedata->province_pixel[x + y * w];
 
 				XMVECTOR Pos = XMLoadFloat3(&mLandVertices[x + y * w].Pos);
 
 				vMin = XMVectorMin(vMin, Pos);
 				vMax = XMVectorMax(vMax, Pos);
 
-				dex = rgb2dex(prov_buf.at(addr + 2), prov_buf.at(addr + 1), prov_buf.at(addr));
-
-				//Registed Province Color
-				if (auto search = prov_key.find(dex); search != prov_key.end())
-				{
-					for (int i = 0; i < 4; i++)
-					{
-						nx = x + W[i][0];
-						ny = y + W[i][0];
-						naddr = 54 + (nx + (ny * w)) * 3;
-						if (nx < w && ny < h)
-						{
-							ndex = rgb2dex(prov_buf.at(naddr + 2), prov_buf.at(naddr + 1), prov_buf.at(naddr));
-							if (dex != ndex)
-							{
-								if (auto nsearch = prov_key.find(ndex); nsearch != prov_key.end())
-								{
-									m_gamedata->province_connect.insert(std::make_pair(std::make_pair(search->second.first, nsearch->second.first), FLT_MAX));
-								}
-							}
-						}
-					}
-					mLandVertices[x + y * w].Prov = search->second.first;
-					if (auto search_stack = m_gamedata->province.find(search->second.first); search_stack == m_gamedata->province.end())
-					{
-						m_gamedata->province.insert(std::make_pair(search->second.first, std::make_unique<Province>(search->second.second, dex, XMFLOAT3(mLandVertices[x + y * w].Pos.x, mLandVertices[x + y * w].Pos.y, mLandVertices[x + y * w].Pos.z))));
-					}
-					else
-					{
-						search_stack->second->pixel.x += mLandVertices[x + y * w].Pos.x;
-						search_stack->second->pixel.y += mLandVertices[x + y * w].Pos.y;
-						search_stack->second->pixel.z += mLandVertices[x + y * w].Pos.z;
-						++search_stack->second->p_num;
-					}
-				}
-				else if (dex * (dex - 8421504) != 0)
-				{
-
-					if (auto O = unregisted_color.find(dex); O == unregisted_color.end())
-					{
-						XMUINT3 u3;
-						syc = MathHelper::Infinity;
-						dex2rgb(R0, G0, B0, dex);
-
-						for (const auto& P : prov_key)
-						{
-							dex2rgb(R1, G1, B1, P.first);
-							if (float get = powf(R0 - R1, 2.f) + powf(G0 - G1, 2.f) + powf(B0 - B1, 2.f); get < syc)
-							{
-								dex2rgb(u3.x, u3.y, u3.z, P.first);
-								syc = get;
-								ind = P.first;
-							}
-						}
-						unregisted_color.insert(std::make_pair(dex, std::make_pair(XMUINT3(std::move(u3)), 1)));
-					}
-					else
-					{
-						O->second.second++;
-					}
-
-				}
-
-
-				//float dx = 0.f, dy = 0.f;
-
 				XMFLOAT3 n = { 0.f, 1.f, 0.f };
 				if (x > 0)
 				{
@@ -4124,26 +2926,6 @@ void MyApp::BuildLandGeometry()
 			}
 		}
 
-		for (const auto& O : unregisted_color)
-		{
-			dex2rgb(r, g, b, O.first);
-			OutputDebugStringA(("Unregisted Color (" + std::to_string(r) + ", " + std::to_string(g) + ", " + std::to_string(b) + ") x " + std::to_string(O.second.second) + " : It looks like (" + std::to_string(O.second.first.x) + ", " + std::to_string(O.second.first.y) + ", " + std::to_string(O.second.first.z) + ")\n").c_str());
-		}
-
-		for (auto& O : m_gamedata->province)
-		{
-			int x = (int)(1.f * O.second->pixel.x / O.second->p_num + (map_w - 1.f) / 2.f);
-			int y = (int)(1.f * O.second->pixel.z / O.second->p_num + (map_h - 1.f) / 2.f);
-
-
-			if (x >= 0 && x < map_w && y >= 0 && y < map_h)
-			{
-				O.second->on3Dpos.x = 2.f * O.second->pixel.x / O.second->p_num;
-				O.second->on3Dpos.y = 2.f * mLandVertices.at(x + map_w * y).Pos.y - 2.f;
-				O.second->on3Dpos.z = 2.f * O.second->pixel.z / O.second->p_num;
-			}
-		}
-
 		concurrency::parallel_for((size_t)1, h - 1, [&](size_t i)
 		{
 			for (size_t j = 1; j < w - 1; ++j)
@@ -4165,22 +2947,6 @@ void MyApp::BuildLandGeometry()
 			}
 		});
 
-		for (auto& O : m_gamedata->province)
-		{
-			for (auto& P : m_gamedata->province)
-			{
-				if (auto Q = m_gamedata->province_connect.find(std::make_pair(O.first, P.first)); Q != m_gamedata->province_connect.end())
-				{
-					float width = sqrtf(powf(O.second->on3Dpos.x - P.second->on3Dpos.x, 2) + powf(O.second->on3Dpos.z - P.second->on3Dpos.z, 2));
-					float height = max(- O.second->on3Dpos.y +P.second->on3Dpos.y, 0);
-					Q->second = width + height;
-					//OutputDebugStringW((O.second->name + L"->" + P.second->name + L" " + Str(Q->second) + L"km\n").c_str());
-				}
-			}
-		}
-
-
-
 		std::vector<std::uint16_t> indices;
 
 		for (std::uint16_t x = 0; x < w - 2; ++x)
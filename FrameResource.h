@@ -3,14 +3,7 @@
 #include "Common/d3dUtil.h"
 #include "Common/MathHelper.h"
 #include "Common/UploadBuffer.h"
-
-
-using ProvinceId = std::uint64_t;
-using LeaderId = std::uint64_t;
-using NationId = std::uint64_t;
-using Color32 = std::uint32_t;
-
-const ProvinceId maxProvince = 256;
+#include "Simulation/SimTypes.h"
 
 struct ObjectConstants
 {
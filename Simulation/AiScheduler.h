@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "SimTypes.h"
+
+// How long a nation waits between finished plans and what they cost.
+struct PlanLatency
+{
+	std::uint64_t plans = 0;
+	// Tick the last plan finished on, and the most ticks between two finished plans.
+	std::uint64_t last_tick = 0;
+	std::uint64_t max_wait = 0;
+	// Microseconds per plan, summed over the ticks it was spread across.
+	double last_us = 0;
+	double total_us = 0;
+	double max_us = 0;
+	// Spent so far on the plan under way.
+	double pending_us = 0;
+};
+
+// Shares each tick's AI time among the nations round-robin.  The nations are taken in
+// ascending id order, starting at the one the saved cursor names (or the next id
+// above it, if that nation is gone) and wrapping around, until budget_us
+// microseconds are spent; the cursor then records where to go on.  A nation cut off
+// among its leaders picks up with the next of them on the following tick.  Every
+// tick makes at least one step, so planning always moves on however small the budget.
+//
+// With budget_us 0 every nation is planned on every tick, from the lowest id up.
+// That is the only setting under which a run is reproducible from its seed.
+class AiScheduler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	std::uint64_t budget_us = 0;
+	// Threads planning nations side by side, counting the one running the tick; 0
+	// means one per hardware thread.  The result does not depend on it.
+	size_t threads = 0;
+
+	// Where planning stopped.  resume is set when nation was cut off part way; leader
+	// is then the index of the next leader to look at in the army the plan started
+	// with, which the caller keeps.
+	struct Cursor
+	{
+		NationId nation = 0;
+		bool resume = false;
+		size_t leader = 0;
+	};
+	Cursor cursor;
+	// False until a tick stopped early, so cursor.nation means something.
+	bool waiting = false;
+
+	void BeginTick() { mStart = Clock::now(); }
+	bool Expired() const
+	{
+		return budget_us && std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - mStart).count() >= (std::int64_t)budget_us;
+	}
+
+	// Books us microseconds of work on nation's plan, finished or not as of tick.
+	void Spent(NationId nation, double us, bool finished, std::uint64_t tick)
+	{
+		PlanLatency& L = mLatency[nation];
+		L.pending_us += us;
+		if (!finished) return;
+
+		if (L.plans) L.max_wait = std::max(L.max_wait, tick - L.last_tick);
+		++L.plans;
+		L.last_tick = tick;
+		L.last_us = L.pending_us;
+		L.total_us += L.pending_us;
+		L.max_us = std::max(L.max_us, L.pending_us);
+		L.pending_us = 0;
+	}
+
+	const std::unordered_map<NationId, PlanLatency>& latency() const { return mLatency; }
+
+private:
+	Clock::time_point mStart;
+	std::unordered_map<NationId, PlanLatency> mLatency;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Unbounded queue any number of threads push to and a single thread pops from,
+// without locks.  A push swaps itself in as the newest node and then links the node
+// before it, so producers never wait on one another or on the consumer; the consumer
+// only follows links.  A push caught between the two steps hides itself and everything
+// after it until it links, and Pop then reports the queue empty for the moment.
+//
+// Pushes from one thread come out in the order they were made.  T must be default
+// constructible, for the node the consumer stands on.
+template<class T>
+class CommandQueue
+{
+public:
+	CommandQueue() : mHead(new Node), mTail(mHead.load(std::memory_order_relaxed)) {}
+	~CommandQueue()
+	{
+		while (Node* N = mTail)
+		{
+			mTail = N->next.load(std::memory_order_relaxed);
+			delete N;
+		}
+	}
+	CommandQueue(const CommandQueue& rhs) = delete;
+	CommandQueue& operator=(const CommandQueue& rhs) = delete;
+
+	void Push(T value)
+	{
+		Node* N = new Node;
+		N->value = std::move(value);
+		Node* prev = mHead.exchange(N, std::memory_order_acq_rel);
+		prev->next.store(N, std::memory_order_release);
+	}
+
+	// Consumer only.
+	bool Pop(T& out)
+	{
+		Node* next = mTail->next.load(std::memory_order_acquire);
+		if (!next) return false;
+		out = std::move(next->value);
+		delete mTail;
+		mTail = next;
+		return true;
+	}
+
+private:
+	struct Node
+	{
+		std::atomic<Node*> next{ nullptr };
+		T value;
+	};
+
+	// Newest node, shared by the producers.
+	std::atomic<Node*> mHead;
+	// Node whose value was popped last; the consumer's alone.
+	Node* mTail;
+};
@@ -0,0 +1,410 @@
+#include "ContractionHierarchy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+namespace
+{
+	const char Magic[4] = { 'P', 'C', 'H', 'B' };
+	// Witness searches give up after this many settled provinces and add the
+	// shortcut; that only costs a few redundant edges.  Estimating a priority uses a
+	// quarter of it.
+	const size_t WitnessLimit = 128;
+
+	const int PriorityEdgeDiff = 2;
+	const int PriorityRemoved = 1;
+	const int PriorityLevel = 1;
+}
+
+void ContractionHierarchy::Build(const ProvinceGraph& graph, std::uint64_t key)
+{
+	mN = graph.capacity();
+	mKey = key;
+	mEpoch = graph.weight_epoch;
+	mWeights = graph.Checksum();
+	mShortcuts = 0;
+
+	const std::uint32_t n = (std::uint32_t)mN;
+	std::vector<std::vector<Edge>> out(n), in(n);
+	std::vector<std::vector<Edge>> up(n), down(n);
+
+	// Keeps one edge per pair, the cheapest.
+	auto link = [&](std::uint32_t a, std::uint32_t b, float w, std::uint32_t mid)
+	{
+		for (auto& E : out[a])
+		{
+			if (E.node != b) continue;
+			if (w < E.weight)
+			{
+				E.weight = w;
+				E.mid = mid;
+				for (auto& F : in[b]) if (F.node == a) F = { a, w, mid };
+			}
+			return;
+		}
+		out[a].push_back({ b, w, mid });
+		in[b].push_back({ a, w, mid });
+	};
+	for (std::uint32_t p = 0; p < n; ++p)
+		for (std::uint32_t e = graph.EdgeBegin(p); e < graph.EdgeEnd(p); ++e)
+			if (graph.to[e] != p && graph.weight[e] != FLT_MAX) link(p, (std::uint32_t)graph.to[e], graph.weight[e], NoNode);
+
+	// Witness search scratch.
+	std::uint32_t stamp = 0;
+	std::vector<std::uint32_t> seen(n, 0);
+	std::vector<std::uint32_t> target(n, 0);
+	std::vector<float> dist(n, FLT_MAX);
+	std::vector<std::pair<float, std::uint32_t>> heap;
+	const auto cmp = std::greater<std::pair<float, std::uint32_t>>();
+
+	struct Shortcut { std::uint32_t from, to; float weight; };
+	std::vector<Shortcut> pending;
+
+	// Counts (or with apply, adds) the shortcuts contracting v needs.
+	auto contract = [&](std::uint32_t v, bool apply) -> int
+	{
+		int count = 0;
+		pending.clear();
+		for (const auto& I : in[v])
+		{
+			++stamp;
+			float bound = -1;
+			size_t left = 0;
+			for (const auto& O : out[v])
+			{
+				if (O.node == I.node) continue;
+				bound = std::max(bound, I.weight + O.weight);
+				target[O.node] = stamp;
+				++left;
+			}
+			if (bound < 0) continue;
+
+			heap.clear();
+			seen[I.node] = stamp;
+			dist[I.node] = 0;
+			heap.push_back(std::make_pair(0.f, I.node));
+			for (size_t settled = 0; !heap.empty() && settled < (apply ? WitnessLimit : WitnessLimit / 4); ++settled)
+			{
+				std::pop_heap(heap.begin(), heap.end(), cmp);
+				const auto [d, x] = heap.back();
+				heap.pop_back();
+				if (d > dist[x]) continue;
+				if (d > bound || (target[x] == stamp && --left == 0)) break;
+				for (const auto& E : out[x])
+				{
+					if (E.node == v) continue;
+					const float nd = d + E.weight;
+					if (seen[E.node] != stamp || nd < dist[E.node])
+					{
+						seen[E.node] = stamp;
+						dist[E.node] = nd;
+						heap.push_back(std::make_pair(nd, E.node));
+						std::push_heap(heap.begin(), heap.end(), cmp);
+					}
+				}
+			}
+
+			for (const auto& O : out[v])
+			{
+				if (O.node == I.node) continue;
+				const float w = I.weight + O.weight;
+				if (seen[O.node] == stamp && dist[O.node] <= w) continue;
+				++count;
+				if (apply) pending.push_back({ I.node, O.node, w });
+			}
+		}
+		for (const auto& S : pending) link(S.from, S.to, S.weight, v);
+		return count;
+	};
+
+	// Edge difference, plus terms that spread the contraction evenly over the map.
+	std::vector<int> removed_neighbours(n, 0);
+	std::vector<int> level(n, 0);
+	auto priority = [&](std::uint32_t v)
+	{
+		return PriorityEdgeDiff * (contract(v, false) - (int)(in[v].size() + out[v].size())) + PriorityRemoved * removed_neighbours[v] + PriorityLevel * level[v];
+	};
+
+	std::vector<std::pair<int, std::uint32_t>> queue;
+	for (std::uint32_t v = 0; v < n; ++v) queue.push_back(std::make_pair(priority(v), v));
+	const auto qcmp = std::greater<std::pair<int, std::uint32_t>>();
+	std::make_heap(queue.begin(), queue.end(), qcmp);
+
+	std::vector<std::uint32_t> touched;
+	mRank.assign(n, 0);
+	for (std::uint32_t rank = 0; !queue.empty();)
+	{
+		std::pop_heap(queue.begin(), queue.end(), qcmp);
+		const std::uint32_t v = queue.back().second;
+		queue.pop_back();
+
+		// Lazy update: a stale priority goes back in unless it is still the lowest.
+		if (const int q = priority(v); !queue.empty() && q > queue.front().first)
+		{
+			queue.push_back(std::make_pair(q, v));
+			std::push_heap(queue.begin(), queue.end(), qcmp);
+			continue;
+		}
+
+		mRank[v] = rank++;
+		mShortcuts += contract(v, true);
+
+		up[v] = out[v];
+		down[v] = in[v];
+		touched.clear();
+		for (const auto& O : out[v])
+		{
+			auto& L = in[O.node];
+			L.erase(std::remove_if(L.begin(), L.end(), [v](const Edge& E) { return E.node == v; }), L.end());
+			touched.push_back(O.node);
+		}
+		for (const auto& I : in[v])
+		{
+			auto& L = out[I.node];
+			L.erase(std::remove_if(L.begin(), L.end(), [v](const Edge& E) { return E.node == v; }), L.end());
+			touched.push_back(I.node);
+		}
+		out[v].clear();
+		in[v].clear();
+
+		std::sort(touched.begin(), touched.end());
+		touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+		for (std::uint32_t w : touched)
+		{
+			++removed_neighbours[w];
+			level[w] = std::max(level[w], level[v] + 1);
+		}
+	}
+
+	mUpOffset.assign(n + 1, 0);
+	mDownOffset.assign(n + 1, 0);
+	mUp.clear();
+	mDown.clear();
+	for (std::uint32_t v = 0; v < n; ++v)
+	{
+		mUp.insert(mUp.end(), up[v].begin(), up[v].end());
+		mDown.insert(mDown.end(), down[v].begin(), down[v].end());
+		mUpOffset[v + 1] = (std::uint32_t)mUp.size();
+		mDownOffset[v + 1] = (std::uint32_t)mDown.size();
+	}
+	mSearch = 0;
+}
+
+std::uint32_t ContractionHierarchy::Search(std::uint32_t s, std::uint32_t t, float& length)
+{
+	length = FLT_MAX;
+	for (auto& S : mSide)
+	{
+		if (S.seen.size() != mN)
+		{
+			S.seen.assign(mN, 0);
+			S.dist.assign(mN, FLT_MAX);
+			S.parent.assign(mN, NoNode);
+			mSearch = 0;
+		}
+		S.heap.clear();
+	}
+	if (++mSearch == 0)
+	{
+		for (auto& S : mSide) std::fill(S.seen.begin(), S.seen.end(), 0);
+		mSearch = 1;
+	}
+
+	const auto cmp = std::greater<std::pair<float, std::uint32_t>>();
+	const std::uint32_t root[2] = { s, t };
+	for (int d = 0; d < 2; ++d)
+	{
+		auto& S = mSide[d];
+		S.seen[root[d]] = mSearch;
+		S.dist[root[d]] = 0;
+		S.parent[root[d]] = NoNode;
+		S.heap.push_back(std::make_pair(0.f, root[d]));
+	}
+
+	std::uint32_t meet = NoNode;
+	for (;;)
+	{
+		// Grow whichever side has the closer frontier; stop once neither can improve.
+		int d = -1;
+		float low = length;
+		for (int k = 0; k < 2; ++k)
+			if (!mSide[k].heap.empty() && mSide[k].heap.front().first < low)
+			{
+				low = mSide[k].heap.front().first;
+				d = k;
+			}
+		if (d < 0) break;
+
+		auto& S = mSide[d];
+		const auto& T = mSide[1 - d];
+		std::pop_heap(S.heap.begin(), S.heap.end(), cmp);
+		const auto [cost, x] = S.heap.back();
+		S.heap.pop_back();
+		if (cost > S.dist[x]) continue;
+
+		if (T.seen[x] == mSearch && cost + T.dist[x] < length)
+		{
+			length = cost + T.dist[x];
+			meet = x;
+		}
+
+		// Stall on demand: when a higher province already reaches x more cheaply from
+		// this side, x lies on no shortest path and need not be expanded.
+		const auto& back_offset = d == 0 ? mDownOffset : mUpOffset;
+		const auto& back_edges = d == 0 ? mDown : mUp;
+		bool stalled = false;
+		for (std::uint32_t e = back_offset[x]; e < back_offset[x + 1] && !stalled; ++e)
+		{
+			const std::uint32_t y = back_edges[e].node;
+			stalled = S.seen[y] == mSearch && S.dist[y] + back_edges[e].weight < cost;
+		}
+		if (stalled) continue;
+
+		const auto& offset = d == 0 ? mUpOffset : mDownOffset;
+		const auto& edges = d == 0 ? mUp : mDown;
+		for (std::uint32_t e = offset[x]; e < offset[x + 1]; ++e)
+		{
+			const std::uint32_t y = edges[e].node;
+			const float nd = cost + edges[e].weight;
+			if (S.seen[y] != mSearch || nd < S.dist[y])
+			{
+				S.seen[y] = mSearch;
+				S.dist[y] = nd;
+				S.parent[y] = x;
+				S.heap.push_back(std::make_pair(nd, y));
+				std::push_heap(S.heap.begin(), S.heap.end(), cmp);
+			}
+		}
+	}
+	return meet;
+}
+
+const ContractionHierarchy::Edge* ContractionHierarchy::FindUp(std::uint32_t a, std::uint32_t b) const
+{
+	for (std::uint32_t e = mUpOffset[a]; e < mUpOffset[a + 1]; ++e)
+		if (mUp[e].node == b) return &mUp[e];
+	return nullptr;
+}
+
+const ContractionHierarchy::Edge* ContractionHierarchy::FindDown(std::uint32_t a, std::uint32_t b) const
+{
+	for (std::uint32_t e = mDownOffset[a]; e < mDownOffset[a + 1]; ++e)
+		if (mDown[e].node == b) return &mDown[e];
+	return nullptr;
+}
+
+void ContractionHierarchy::Unpack(std::uint32_t a, std::uint32_t b, std::vector<std::uint32_t>& out) const
+{
+	// The edge a -> b was stored under whichever end was contracted first.
+	const Edge* E = mRank[b] > mRank[a] ? FindUp(a, b) : FindDown(b, a);
+	if (!E || E->mid == NoNode)
+	{
+		out.push_back(b);
+		return;
+	}
+	Unpack(a, E->mid, out);
+	Unpack(E->mid, b, out);
+}
+
+float ContractionHierarchy::Distance(ProvinceId start, ProvinceId end)
+{
+	if (start == end) return 0;
+	if (start >= mN || end >= mN) return FLT_MAX;
+
+	// Find(start, end) measures the graph path end -> start.
+	float length;
+	Search((std::uint32_t)end, (std::uint32_t)start, length);
+	return length;
+}
+
+ProvincePath ContractionHierarchy::Path(ProvinceId start, ProvinceId end)
+{
+	ProvincePath R;
+	if (start == end) return R;
+
+	R.length = FLT_MAX;
+	if (start >= mN || end >= mN) return R;
+
+	float length;
+	const std::uint32_t meet = Search((std::uint32_t)end, (std::uint32_t)start, length);
+	if (meet == NoNode) return R;
+	R.length = length;
+
+	std::vector<std::uint32_t> climb;
+	for (std::uint32_t x = meet; x != NoNode; x = mSide[0].parent[x]) climb.push_back(x);
+	std::reverse(climb.begin(), climb.end());
+
+	std::vector<std::uint32_t> nodes{ (std::uint32_t)end };
+	for (size_t i = 1; i < climb.size(); ++i) Unpack(climb[i - 1], climb[i], nodes);
+	for (std::uint32_t x = meet; mSide[1].parent[x] != NoNode; x = mSide[1].parent[x]) Unpack(x, mSide[1].parent[x], nodes);
+
+	// nodes runs end .. start; the walk goes the other way and leaves start out.
+	for (size_t i = nodes.size() - 1; i-- > 0;) R.path.push_back(nodes[i]);
+	return R;
+}
+
+bool ContractionHierarchy::Load(const std::string& path, std::uint64_t key, const ProvinceGraph& graph)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+
+	char magic[4];
+	std::uint32_t version = 0;
+	std::uint64_t file_key = 0, weights = 0, n = 0, shortcuts = 0, up = 0, down = 0;
+	file.read(magic, sizeof(magic));
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&file_key, sizeof(file_key));
+	file.read((char*)&weights, sizeof(weights));
+	file.read((char*)&n, sizeof(n));
+	file.read((char*)&shortcuts, sizeof(shortcuts));
+	file.read((char*)&up, sizeof(up));
+	file.read((char*)&down, sizeof(down));
+	if (!file || memcmp(magic, Magic, sizeof(Magic)) != 0 || version != Version || file_key != key || weights != graph.Checksum() || n != graph.capacity()) return false;
+
+	std::vector<std::uint32_t> rank(n), up_offset(n + 1), down_offset(n + 1);
+	std::vector<Edge> up_edges(up), down_edges(down);
+	file.read((char*)rank.data(), rank.size() * sizeof(std::uint32_t));
+	file.read((char*)up_offset.data(), up_offset.size() * sizeof(std::uint32_t));
+	file.read((char*)up_edges.data(), up_edges.size() * sizeof(Edge));
+	file.read((char*)down_offset.data(), down_offset.size() * sizeof(std::uint32_t));
+	file.read((char*)down_edges.data(), down_edges.size() * sizeof(Edge));
+	if (!file) return false;
+
+	mN = (size_t)n;
+	mKey = key;
+	mEpoch = graph.weight_epoch;
+	mWeights = weights;
+	mShortcuts = (size_t)shortcuts;
+	mRank = std::move(rank);
+	mUpOffset = std::move(up_offset);
+	mUp = std::move(up_edges);
+	mDownOffset = std::move(down_offset);
+	mDown = std::move(down_edges);
+	mSearch = 0;
+	return true;
+}
+
+bool ContractionHierarchy::Save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) return false;
+
+	const std::uint32_t version = Version;
+	const std::uint64_t n = mN, shortcuts = mShortcuts, up = mUp.size(), down = mDown.size();
+	file.write(Magic, sizeof(Magic));
+	file.write((const char*)&version, sizeof(version));
+	file.write((const char*)&mKey, sizeof(mKey));
+	file.write((const char*)&mWeights, sizeof(mWeights));
+	file.write((const char*)&n, sizeof(n));
+	file.write((const char*)&shortcuts, sizeof(shortcuts));
+	file.write((const char*)&up, sizeof(up));
+	file.write((const char*)&down, sizeof(down));
+	file.write((const char*)mRank.data(), mRank.size() * sizeof(std::uint32_t));
+	file.write((const char*)mUpOffset.data(), mUpOffset.size() * sizeof(std::uint32_t));
+	file.write((const char*)mUp.data(), mUp.size() * sizeof(Edge));
+	file.write((const char*)mDownOffset.data(), mDownOffset.size() * sizeof(std::uint32_t));
+	file.write((const char*)mDown.data(), mDown.size() * sizeof(Edge));
+	return (bool)file;
+}
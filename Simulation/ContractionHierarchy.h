@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SimTypes.h"
+#include "ProvinceStore.h"
+#include "ProvinceGraph.h"
+#include "PathFinder.h"
+
+// Contraction hierarchy over the province graph for fast point-to-point queries on
+// large maps.  Provinces are contracted one at a time in order of importance, adding
+// a shortcut wherever a shortest path ran through the removed province.  A query
+// is then a bidirectional Dijkstra that only climbs the order, which settles a few
+// dozen provinces instead of a large part of the map.
+//
+// Like DistanceTable it depends only on the geometric weights, never the tolls, so it
+// can be stored next to the map, keyed by the map hash and the weights' checksum.
+// Costs follow PathFinder::Find with NoNation.
+class ContractionHierarchy
+{
+public:
+	static constexpr std::uint32_t Version = 2;
+
+	void Build(const ProvinceGraph& graph, std::uint64_t key);
+	// Fails when the file is missing, from another version, or built for another key
+	// or other weights than graph has.
+	bool Load(const std::string& path, std::uint64_t key, const ProvinceGraph& graph);
+	bool Save(const std::string& path) const;
+
+	bool empty() const { return mN == 0; }
+	std::uint64_t key() const { return mKey; }
+	// ProvinceGraph::weight_epoch the index was built or loaded for.
+	std::uint64_t epoch() const { return mEpoch; }
+	size_t shortcut_count() const { return mShortcuts; }
+
+	// Same results as PathFinder::Find(start, end, NoNation).
+	float Distance(ProvinceId start, ProvinceId end);
+	ProvincePath Path(ProvinceId start, ProvinceId end);
+
+private:
+	static constexpr std::uint32_t NoNode = 0xFFFFFFFFu;
+
+	struct Edge
+	{
+		std::uint32_t node;
+		float weight;
+		// Contracted province a shortcut bypasses, NoNode for an original edge.
+		std::uint32_t mid;
+	};
+
+	// Runs the query for the graph path s -> t; returns the meeting node or NoNode.
+	std::uint32_t Search(std::uint32_t s, std::uint32_t t, float& length);
+	// Appends the graph path of edge a -> b, without a, to out.
+	void Unpack(std::uint32_t a, std::uint32_t b, std::vector<std::uint32_t>& out) const;
+	const Edge* FindUp(std::uint32_t a, std::uint32_t b) const;
+	const Edge* FindDown(std::uint32_t a, std::uint32_t b) const;
+
+	size_t mN = 0;
+	std::uint64_t mKey = 0;
+	std::uint64_t mEpoch = 0;
+	std::uint64_t mWeights = 0;
+	size_t mShortcuts = 0;
+
+	std::vector<std::uint32_t> mRank;
+	// mUp lists the edges a -> b with rank[b] > rank[a] under a; mDown lists the
+	// edges b -> a with rank[b] > rank[a] under a, node being b.
+	std::vector<std::uint32_t> mUpOffset;
+	std::vector<Edge> mUp;
+	std::vector<std::uint32_t> mDownOffset;
+	std::vector<Edge> mDown;
+
+	// Query scratch for both directions, stamped like PathFinder's.
+	struct Side
+	{
+		std::vector<std::uint32_t> seen;
+		std::vector<float> dist;
+		std::vector<std::uint32_t> parent;
+		std::vector<std::pair<float, std::uint32_t>> heap;
+	};
+	std::uint32_t mSearch = 0;
+	Side mSide[2];
+};
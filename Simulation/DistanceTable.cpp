@@ -0,0 +1,105 @@
+#include "DistanceTable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+	const char Magic[4] = { 'P', 'D', 'T', 'B' };
+}
+
+void DistanceTable::Build(const ProvinceStore& prov, const ProvinceGraph& graph, std::uint64_t key)
+{
+	mN = graph.capacity();
+	mKey = key;
+	mEpoch = graph.weight_epoch;
+	mWeights = graph.Checksum();
+	mDist.assign(mN * mN, FLT_MAX);
+	mNext.assign(mN * mN, 0);
+	if (mN == 0) return;
+
+	size_t workers = std::max(1u, std::thread::hardware_concurrency());
+	workers = std::min(workers, mN);
+
+	// Each worker floods every workers-th destination with its own scratch and only
+	// writes the rows it owns.
+	auto run = [&](size_t first)
+	{
+		PathFinder finder(prov, graph);
+		for (size_t End = first; End < mN; End += workers)
+		{
+			if (!prov.contains(End)) continue;
+			finder.Flood(End, NoNation, &mDist[End * mN], &mNext[End * mN]);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < workers; ++i) threads.emplace_back(run, i);
+	run(0);
+	for (auto& T : threads) T.join();
+}
+
+ProvincePath DistanceTable::Path(ProvinceId start, ProvinceId end) const
+{
+	ProvincePath R;
+	if (start == end) return R;
+
+	R.length = Distance(start, end);
+	if (R.length == FLT_MAX) return R;
+
+	for (ProvinceId Index = start; Index != end;)
+	{
+		Index = NextHop(Index, end);
+		R.path.push_back(Index);
+	}
+	return R;
+}
+
+bool DistanceTable::Load(const std::string& path, std::uint64_t key, const ProvinceGraph& graph)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+
+	char magic[4];
+	std::uint32_t version = 0;
+	std::uint64_t file_key = 0, weights = 0, n = 0;
+	file.read(magic, sizeof(magic));
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&file_key, sizeof(file_key));
+	file.read((char*)&weights, sizeof(weights));
+	file.read((char*)&n, sizeof(n));
+	if (!file || memcmp(magic, Magic, sizeof(Magic)) != 0 || version != Version || file_key != key || weights != graph.Checksum() || n != graph.capacity()) return false;
+
+	std::vector<float> dist(n * n);
+	std::vector<std::uint32_t> next(n * n);
+	file.read((char*)dist.data(), dist.size() * sizeof(float));
+	file.read((char*)next.data(), next.size() * sizeof(std::uint32_t));
+	if (!file) return false;
+
+	mN = (size_t)n;
+	mKey = key;
+	mEpoch = graph.weight_epoch;
+	mWeights = weights;
+	mDist = std::move(dist);
+	mNext = std::move(next);
+	return true;
+}
+
+bool DistanceTable::Save(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) return false;
+
+	const std::uint32_t version = Version;
+	const std::uint64_t n = mN;
+	file.write(Magic, sizeof(Magic));
+	file.write((const char*)&version, sizeof(version));
+	file.write((const char*)&mKey, sizeof(mKey));
+	file.write((const char*)&mWeights, sizeof(mWeights));
+	file.write((const char*)&n, sizeof(n));
+	file.write((const char*)mDist.data(), mDist.size() * sizeof(float));
+	file.write((const char*)mNext.data(), mNext.size() * sizeof(std::uint32_t));
+	return (bool)file;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SimTypes.h"
+#include "ProvinceStore.h"
+#include "ProvinceGraph.h"
+#include "PathFinder.h"
+
+// All-pairs path lengths and next hops over the province graph.  Row End holds the
+// result of PathFinder::Flood(End, NoNation), so Distance(a, b) equals
+// Find(a, b, NoNation).length: the geometric weights, without tolls, which is what
+// lets it outlive every ruler change; Data::Route answers toll-free routes from it.
+// Simulation::PrepareDistances builds it once (in parallel) right after the map loads
+// and stores it next to the map, keyed by a hash of the files it came from and
+// ProvinceGraph::Checksum of the weights it was built on.
+class DistanceTable
+{
+public:
+	static constexpr std::uint32_t Version = 2;
+	// Above this many provinces the table (n * n entries) is not worth its memory;
+	// Data::Route falls back to the region graph.
+	static constexpr size_t MaxProvinces = 4096;
+
+	void Build(const ProvinceStore& prov, const ProvinceGraph& graph, std::uint64_t key);
+	// Fails when the file is missing, from another version, or built for another key
+	// or other weights than graph has.
+	bool Load(const std::string& path, std::uint64_t key, const ProvinceGraph& graph);
+	bool Save(const std::string& path) const;
+
+	bool empty() const { return mN == 0; }
+	std::uint64_t key() const { return mKey; }
+	// ProvinceGraph::weight_epoch the table was built or loaded for.
+	std::uint64_t epoch() const { return mEpoch; }
+
+	// FLT_MAX when unreachable or out of range, 0 when start == end.
+	float Distance(ProvinceId start, ProvinceId end) const
+	{
+		if (start >= mN || end >= mN) return FLT_MAX;
+		return mDist[end * mN + start];
+	}
+	// First province after start on the way to end, 0 when there is none.
+	ProvinceId NextHop(ProvinceId start, ProvinceId end) const
+	{
+		if (start >= mN || end >= mN || start == end) return 0;
+		return mNext[end * mN + start];
+	}
+	ProvincePath Path(ProvinceId start, ProvinceId end) const;
+
+private:
+	size_t mN = 0;
+	std::uint64_t mKey = 0;
+	std::uint64_t mEpoch = 0;
+	std::uint64_t mWeights = 0;
+	std::vector<float> mDist;
+	std::vector<std::uint32_t> mNext;
+};
@@ -0,0 +1,197 @@
+#include "Economy.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define ECONOMY_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define ECONOMY_AVX2
+#else
+#define ECONOMY_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	void DriftScalar(std::int64_t* man, const std::int64_t* maxman, const float* rate, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i) man[i] += ProvinceStore::Drift(man[i], maxman[i], rate ? rate[i] : 1.0);
+	}
+
+	void RepairScalar(std::int64_t* hp, const std::int64_t* p_num, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			if (hp[i] < 0) hp[i] = 0;
+			else if (hp[i] >= p_num[i]) hp[i] = p_num[i];
+			else hp[i] += 1;
+		}
+	}
+
+#ifdef ECONOMY_X86
+	// Adding 2^52 + 2^51 to an integer below 2^51 in magnitude lines it up with the
+	// mantissa of a double, so the conversions both ways are a single add.
+	constexpr std::int64_t MagicBits = 0x4338000000000000ll;
+	constexpr double Magic = 6755399441055744.0;
+
+	// Two provinces per register.  SSE2 is always there on x64.
+	void DriftSse2(std::int64_t* man, const std::int64_t* maxman, const float* rate, size_t n)
+	{
+		const __m128i magic_i = _mm_set1_epi64x(MagicBits);
+		const __m128d magic = _mm_set1_pd(Magic);
+		const __m128d scale = _mm_set1_pd(1200.0);
+		const __m128d lo = _mm_set1_pd(-10.0);
+		const __m128d hi = _mm_set1_pd(10.0);
+		const __m128d half = _mm_set1_pd(0.5);
+		const __m128d one = _mm_set1_pd(1.0);
+		const __m128d sign = _mm_set1_pd(-0.0);
+
+		size_t i = 0;
+		for (; i + 2 <= n; i += 2)
+		{
+			const __m128i m = _mm_loadu_si128((const __m128i*)(man + i));
+			const __m128i d = _mm_sub_epi64(_mm_loadu_si128((const __m128i*)(maxman + i)), m);
+			__m128d x = _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(d, magic_i)), magic);
+			x = _mm_div_pd(x, scale);
+			if (rate) x = _mm_mul_pd(x, _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)(rate + i)))));
+			x = _mm_min_pd(_mm_max_pd(x, lo), hi);
+
+			// std::round: truncate, then one away from zero when at least a half was cut.
+			const __m128d t = _mm_cvtepi32_pd(_mm_cvttpd_epi32(x));
+			const __m128d cut = _mm_andnot_pd(sign, _mm_sub_pd(x, t));
+			const __m128d away = _mm_and_pd(_mm_cmpge_pd(cut, half), _mm_or_pd(_mm_and_pd(x, sign), one));
+			const __m128d r = _mm_add_pd(_mm_add_pd(t, away), magic);
+			_mm_storeu_si128((__m128i*)(man + i), _mm_add_epi64(m, _mm_sub_epi64(_mm_castpd_si128(r), magic_i)));
+		}
+		DriftScalar(man + i, maxman + i, rate ? rate + i : nullptr, n - i);
+	}
+
+	void RepairSse2(std::int64_t* hp, const std::int64_t* p_num, size_t n)
+	{
+		const __m128i magic_i = _mm_set1_epi64x(MagicBits);
+		const __m128d magic = _mm_set1_pd(Magic);
+		const __m128d zero = _mm_setzero_pd();
+		const __m128d one = _mm_set1_pd(1.0);
+
+		size_t i = 0;
+		for (; i + 2 <= n; i += 2)
+		{
+			const __m128d h = _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(_mm_loadu_si128((const __m128i*)(hp + i)), magic_i)), magic);
+			const __m128d p = _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(_mm_loadu_si128((const __m128i*)(p_num + i)), magic_i)), magic);
+			const __m128d r = _mm_andnot_pd(_mm_cmplt_pd(h, zero), _mm_min_pd(_mm_add_pd(h, one), p));
+			_mm_storeu_si128((__m128i*)(hp + i), _mm_sub_epi64(_mm_castpd_si128(_mm_add_pd(r, magic)), magic_i));
+		}
+		RepairScalar(hp + i, p_num + i, n - i);
+	}
+
+	// Four provinces per register, two registers per pass, so eight at a time.
+	ECONOMY_AVX2 inline void DriftAvx2Step(std::int64_t* man, const std::int64_t* maxman, const float* rate)
+	{
+		const __m256i magic_i = _mm256_set1_epi64x(MagicBits);
+		const __m256d magic = _mm256_set1_pd(Magic);
+		const __m256d sign = _mm256_set1_pd(-0.0);
+
+		const __m256i m = _mm256_loadu_si256((const __m256i*)man);
+		const __m256i d = _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*)maxman), m);
+		__m256d x = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(d, magic_i)), magic);
+		x = _mm256_div_pd(x, _mm256_set1_pd(1200.0));
+		if (rate) x = _mm256_mul_pd(x, _mm256_cvtps_pd(_mm_loadu_ps(rate)));
+		x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-10.0)), _mm256_set1_pd(10.0));
+
+		const __m256d t = _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(x));
+		const __m256d cut = _mm256_andnot_pd(sign, _mm256_sub_pd(x, t));
+		const __m256d away = _mm256_and_pd(_mm256_cmp_pd(cut, _mm256_set1_pd(0.5), _CMP_GE_OQ), _mm256_or_pd(_mm256_and_pd(x, sign), _mm256_set1_pd(1.0)));
+		const __m256i r = _mm256_cvtepi32_epi64(_mm256_cvttpd_epi32(_mm256_add_pd(t, away)));
+		_mm256_storeu_si256((__m256i*)man, _mm256_add_epi64(m, r));
+	}
+
+	ECONOMY_AVX2 void DriftAvx2(std::int64_t* man, const std::int64_t* maxman, const float* rate, size_t n)
+	{
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			DriftAvx2Step(man + i, maxman + i, rate ? rate + i : nullptr);
+			DriftAvx2Step(man + i + 4, maxman + i + 4, rate ? rate + i + 4 : nullptr);
+		}
+		for (; i + 4 <= n; i += 4) DriftAvx2Step(man + i, maxman + i, rate ? rate + i : nullptr);
+		DriftScalar(man + i, maxman + i, rate ? rate + i : nullptr, n - i);
+	}
+
+	ECONOMY_AVX2 void RepairAvx2(std::int64_t* hp, const std::int64_t* p_num, size_t n)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i one = _mm256_set1_epi64x(1);
+
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m256i h = _mm256_loadu_si256((const __m256i*)(hp + i));
+			const __m256i p = _mm256_loadu_si256((const __m256i*)(p_num + i));
+			const __m256i up = _mm256_add_epi64(h, one);
+			const __m256i r = _mm256_blendv_epi8(up, p, _mm256_cmpgt_epi64(up, p));
+			_mm256_storeu_si256((__m256i*)(hp + i), _mm256_andnot_si256(_mm256_cmpgt_epi64(zero, h), r));
+		}
+		RepairScalar(hp + i, p_num + i, n - i);
+	}
+
+	bool HasAvx2()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		// The OS has to save the YMM registers as well (OSXSAVE, then XCR0 bits 1-2).
+		if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6) return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+}
+
+const std::vector<EconomyKernel>& EconomyKernels()
+{
+	static const std::vector<EconomyKernel> kernels = []
+	{
+		std::vector<EconomyKernel> K{ { "scalar", DriftScalar, RepairScalar } };
+#ifdef ECONOMY_X86
+		K.push_back({ "sse2", DriftSse2, RepairSse2 });
+		if (HasAvx2()) K.push_back({ "avx2", DriftAvx2, RepairAvx2 });
+#endif
+		return K;
+	}();
+	return kernels;
+}
+
+const EconomyKernel& Economy()
+{
+	return EconomyKernels().back();
+}
+
+void EconomyBatch::Gather(const ProvinceStore& prov, const std::vector<ProvinceId>& ids)
+{
+	const size_t n = ids.size();
+	man.resize(n);
+	maxman.resize(n);
+	hp.resize(n);
+	p_num.resize(n);
+	rate.assign(n, 0.f);
+	for (size_t i = 0; i < n; ++i)
+	{
+		const ProvinceId O = ids[i];
+		man[i] = prov.man[O];
+		maxman[i] = prov.maxman[O];
+		hp[i] = prov.hp[O];
+		p_num[i] = prov.p_num[O];
+	}
+}
+
+void EconomyBatch::Scatter(ProvinceStore& prov, const std::vector<ProvinceId>& ids) const
+{
+	for (size_t i = 0; i < ids.size(); ++i)
+	{
+		prov.man[ids[i]] = man[i];
+		prov.hp[ids[i]] = hp[i];
+	}
+}
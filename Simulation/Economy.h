@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SimTypes.h"
+#include "ProvinceStore.h"
+
+// The per-province regeneration step of the tick as kernels over contiguous
+// columns.  Every kernel gives exactly what ProvinceStore::Drift and the scalar hp
+// step give: the arithmetic stays in doubles, which holds man, maxman and hp exactly
+// below 2^51.
+struct EconomyKernel
+{
+	const char* name;
+	// man[i] += ProvinceStore::Drift(man[i], maxman[i], rate[i]); a null rate means 1.
+	void (*drift)(std::int64_t* man, const std::int64_t* maxman, const float* rate, size_t n);
+	// Negative hp to 0, otherwise one more up to p_num.
+	void (*repair)(std::int64_t* hp, const std::int64_t* p_num, size_t n);
+};
+
+// The kernels this build has that the CPU can run, scalar first.
+const std::vector<EconomyKernel>& EconomyKernels();
+// The fastest of them.
+const EconomyKernel& Economy();
+
+// Columns of a list of provinces copied into contiguous arrays for the kernels.
+struct EconomyBatch
+{
+	std::vector<std::int64_t> man;
+	std::vector<std::int64_t> maxman;
+	std::vector<std::int64_t> hp;
+	std::vector<std::int64_t> p_num;
+	// The nation's abb_man for the second drift, 0 where there is none.
+	std::vector<float> rate;
+
+	void Gather(const ProvinceStore& prov, const std::vector<ProvinceId>& ids);
+	// Writes man and hp back.
+	void Scatter(ProvinceStore& prov, const std::vector<ProvinceId>& ids) const;
+};
@@ -0,0 +1,103 @@
+//***************************************************************************************
+// EconomyBench.cpp
+//
+// Times the regeneration kernels of Economy.h on random province columns: one tick's
+// two man drifts and hp step, as Simulation::Tick runs them over the awake provinces.
+// Every kernel's output is checked against the scalar one.
+//
+//   economybench [--reps N] [--seed N] [sizes...]      (default sizes 256 4096 65536)
+//***************************************************************************************
+
+#include "Economy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Columns
+	{
+		std::vector<std::int64_t> man, maxman, hp, p_num;
+		std::vector<float> rate;
+	};
+
+	Columns MakeColumns(size_t count, std::mt19937& mt)
+	{
+		const float rates[] = { 0.f, 0.2f, 1.f, 1.2f, 1.25f, 1.5f, 10.f };
+		Columns C;
+		for (size_t i = 0; i < count; ++i)
+		{
+			C.maxman.push_back(4000 + mt() % 40000);
+			C.man.push_back((std::int64_t)(mt() % 50000) - 2000);
+			C.p_num.push_back(1 + mt() % 3000);
+			C.hp.push_back((std::int64_t)(mt() % 3500) - 300);
+			C.rate.push_back(rates[mt() % 7]);
+		}
+		return C;
+	}
+
+	void Run(const EconomyKernel& K, Columns& C)
+	{
+		const size_t n = C.man.size();
+		K.drift(C.man.data(), C.maxman.data(), nullptr, n);
+		K.drift(C.man.data(), C.maxman.data(), C.rate.data(), n);
+		K.repair(C.hp.data(), C.p_num.data(), n);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t reps = 0;
+	std::uint32_t seed = 1;
+	std::vector<size_t> sizes;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--reps") && i + 1 < argc) reps = std::stoul(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (std::uint32_t)std::stoul(argv[++i]);
+		else sizes.push_back(std::stoul(argv[i]));
+	}
+	if (sizes.empty()) sizes = { 256, 4096, 65536 };
+
+	const auto& kernels = EconomyKernels();
+	printf("%8s %8s %12s %14s %9s %9s\n", "provs", "kernel", "ns/tick", "Mprov/s", "speedup", "mismatch");
+	for (size_t count : sizes)
+	{
+		std::mt19937 mt(seed);
+		const Columns start = MakeColumns(count, mt);
+		// Enough ticks for about 2^26 province updates.
+		const size_t ticks = reps ? reps : std::max<size_t>(64, (size_t(1) << 26) / count);
+
+		// Drifting towards maxman changes the input every tick, so compare after each.
+		Columns expect = start;
+		std::vector<Columns> results(kernels.size(), start);
+		size_t mismatch = 0;
+		for (size_t t = 0; t < 64; ++t)
+		{
+			Run(kernels[0], expect);
+			for (size_t k = 1; k < kernels.size(); ++k)
+			{
+				Run(kernels[k], results[k]);
+				mismatch += results[k].man != expect.man || results[k].hp != expect.hp;
+			}
+		}
+
+		double scalar = 0;
+		for (const auto& K : kernels)
+		{
+			Columns C = start;
+			const auto begin = Clock::now();
+			for (size_t t = 0; t < ticks; ++t) Run(K, C);
+			const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+			const double ns = seconds * 1e9 / ticks;
+			if (!scalar) scalar = ns;
+			printf("%8zu %8s %12.1f %14.1f %8.2fx %9zu\n", count, K.name, ns, count * 1e3 / ns, scalar / ns, mismatch);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,57 @@
+#include "FlowField.h"
+
+#include <stdexcept>
+
+const FlowField& FlowFieldService::Acquire(ProvinceId target, NationId mover)
+{
+	auto [O, added] = mFields.try_emplace(std::make_pair(target, mover));
+	FlowField& F = O->second;
+	if (added)
+	{
+		F.target = target;
+		F.mover = mover;
+		++misses;
+	}
+	else ++hits;
+	++F.refs;
+	Refresh(F);
+	return F;
+}
+
+void FlowFieldService::Release(ProvinceId target, NationId mover)
+{
+	auto O = mFields.find(std::make_pair(target, mover));
+	if (O == mFields.end()) return;
+	if (--O->second.refs == 0)
+	{
+		mFields.erase(O);
+		++evictions;
+	}
+}
+
+const FlowField& FlowFieldService::Get(ProvinceId target, NationId mover)
+{
+	auto O = mFields.find(std::make_pair(target, mover));
+	if (O == mFields.end()) throw std::out_of_range("FlowFieldService::Get");
+	Refresh(O->second);
+	return O->second;
+}
+
+void FlowFieldService::Refresh(FlowField& F)
+{
+	if (!F.dist.empty() && F.epoch == mGraph.epoch) return;
+
+	if (F.dist.size() == mGraph.capacity() && mGraph.ChangedSince(F.epoch, mChanged))
+	{
+		mFinder.Repair(mChanged.data(), mChanged.size(), F.mover, F.dist.data(), F.next.data());
+		++repairs;
+	}
+	else
+	{
+		F.dist.resize(mGraph.capacity());
+		F.next.resize(mGraph.capacity());
+		mFinder.Flood(F.target, F.mover, F.dist.data(), F.next.data());
+		++builds;
+	}
+	F.epoch = mGraph.epoch;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "SimTypes.h"
+#include "ProvinceStore.h"
+#include "ProvinceGraph.h"
+#include "PathFinder.h"
+
+// Next hop from every province towards one target for one nation's armies, shared
+// by every leader of theirs heading there.
+struct FlowField
+{
+	ProvinceId target = 0;
+	NationId mover = NoNation;
+	std::uint64_t epoch = 0;
+	std::uint32_t refs = 0;
+	std::vector<float> dist;
+	std::vector<std::uint32_t> next;
+
+	bool Reachable(ProvinceId from) const { return from < dist.size() && dist[from] != FLT_MAX; }
+	// 0 when from is the target or cannot reach it.
+	ProvinceId Next(ProvinceId from) const { return from < next.size() && from != target ? next[from] : 0; }
+};
+
+// Reference-counted flow fields, one per target province and nation in use, since
+// each nation pays its own tolls.  A field is built on the first Acquire, repaired
+// when tolls change (rebuilt if the graph was reweighted), and dropped when its last
+// holder releases it, so the work follows the number of distinct goals rather than
+// the number of armies walking to them.
+class FlowFieldService
+{
+public:
+	FlowFieldService(const ProvinceStore& prov, const ProvinceGraph& graph) : mGraph(graph), mFinder(prov, graph) {}
+	FlowFieldService(const FlowFieldService& rhs) = delete;
+	FlowFieldService& operator=(const FlowFieldService& rhs) = delete;
+
+	const FlowField& Acquire(ProvinceId target, NationId mover);
+	void Release(ProvinceId target, NationId mover);
+	// The field for a target someone holds, brought up to date first.
+	const FlowField& Get(ProvinceId target, NationId mover);
+
+	size_t size() const { return mFields.size(); }
+
+	// An Acquire hits when someone already holds the field, so no new search is
+	// started for it, and misses otherwise.
+	std::uint64_t hits = 0;
+	std::uint64_t misses = 0;
+	std::uint64_t builds = 0;
+	std::uint64_t repairs = 0;
+	std::uint64_t evictions = 0;
+
+private:
+	void Refresh(FlowField& F);
+
+	const ProvinceGraph& mGraph;
+	PathFinder mFinder;
+	std::map<std::pair<ProvinceId, NationId>, FlowField> mFields;
+	std::vector<ProvinceId> mChanged;
+};
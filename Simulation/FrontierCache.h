@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "SimTypes.h"
+#include "ProvinceGraph.h"
+#include "PathFinder.h"
+
+// Per-nation distance from every province to the nearest province the nation owns or
+// rules, from one multi-source PathFinder::Flood with the nation's own tolls.  An
+// entry is reused until the nation's territory changes, and repaired in place when
+// only tolls changed.
+class FrontierCache
+{
+public:
+	// territory must list the nation's provinces in ascending order.
+	const std::vector<float>& Get(NationId nation, const std::vector<ProvinceId>& territory, PathFinder& finder, const ProvinceGraph& graph)
+	{
+		Entry& E = mEntries[nation];
+		if (E.valid && E.territory == territory)
+		{
+			if (E.epoch == graph.epoch)
+			{
+				++hits;
+				return E.dist;
+			}
+			if (E.dist.size() == graph.capacity() && graph.ChangedSince(E.epoch, mChanged))
+			{
+				++repairs;
+				E.epoch = graph.epoch;
+				finder.Repair(mChanged.data(), mChanged.size(), nation, E.dist.data(), E.next.data());
+				return E.dist;
+			}
+		}
+
+		++misses;
+		E.valid = true;
+		E.epoch = graph.epoch;
+		E.territory = territory;
+		E.dist.resize(graph.capacity());
+		E.next.resize(graph.capacity());
+		finder.Flood(territory.data(), territory.size(), nation, E.dist.data(), E.next.data());
+		return E.dist;
+	}
+
+	void Invalidate(NationId nation) { mEntries.erase(nation); }
+	void clear() { mEntries.clear(); }
+
+	std::uint64_t hits = 0;
+	std::uint64_t misses = 0;
+	std::uint64_t repairs = 0;
+
+private:
+	struct Entry
+	{
+		bool valid = false;
+		std::uint64_t epoch = 0;
+		std::vector<ProvinceId> territory;
+		std::vector<float> dist;
+		std::vector<std::uint32_t> next;
+	};
+	std::unordered_map<NationId, Entry> mEntries;
+	std::vector<ProvinceId> mChanged;
+};
@@ -0,0 +1,136 @@
+//***************************************************************************************
+// Headless.cpp
+//
+// Runs the campaign simulation without a window.  Run it from the repository root so
+// Map/ and UserData/ resolve the same way they do for the game.
+//
+//   headless [--seed N] [--ticks N] [--ch] [--ai-budget US] [--ai-threads N]
+//
+// --ch also prepares the contraction hierarchy (Map/path.ch), as the game does on
+// maps too large for the distance table.  --ai-budget caps the AI at US microseconds
+// a tick (see AiScheduler); the final state then depends on timing.  --ai-threads
+// sets how many threads plan nations, which never changes the final state.
+//***************************************************************************************
+
+#include "Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <iconv.h>
+#endif
+
+// Map/prov.txt and UserData/Nation are stored in CP949.
+static std::wstring DecodeCP949(const std::vector<unsigned char>& bytes)
+{
+	std::wstring out;
+	if (bytes.empty()) return out;
+#ifdef _WIN32
+	int n = MultiByteToWideChar(949, 0, (const char*)bytes.data(), (int)bytes.size(), nullptr, 0);
+	out.resize(n);
+	MultiByteToWideChar(949, 0, (const char*)bytes.data(), (int)bytes.size(), out.data(), n);
+#else
+	iconv_t cd = iconv_open("WCHAR_T", "CP949");
+	if (cd == (iconv_t)-1) return out;
+	out.resize(bytes.size());
+	char* in = (char*)bytes.data();
+	size_t in_left = bytes.size();
+	char* dst = (char*)out.data();
+	size_t dst_left = out.size() * sizeof(wchar_t);
+	iconv(cd, &in, &in_left, &dst, &dst_left);
+	iconv_close(cd);
+	out.resize(out.size() - dst_left / sizeof(wchar_t));
+#endif
+	return out;
+}
+
+static std::vector<unsigned char> ReadFile(const char* path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv)
+{
+	std::uint32_t seed = 1;
+	std::uint64_t ticks = 1000;
+	bool hierarchy = false;
+	std::uint64_t ai_budget = 0;
+	size_t ai_threads = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (std::uint32_t)std::stoul(argv[++i]);
+		else if (!strcmp(argv[i], "--ticks") && i + 1 < argc) ticks = std::stoull(argv[++i]);
+		else if (!strcmp(argv[i], "--ch")) hierarchy = true;
+		else if (!strcmp(argv[i], "--ai-budget") && i + 1 < argc) ai_budget = std::stoull(argv[++i]);
+		else if (!strcmp(argv[i], "--ai-threads") && i + 1 < argc) ai_threads = std::stoul(argv[++i]);
+	}
+
+	auto map_bmp = ReadFile("Map/map.bmp");
+	auto prov_bmp = ReadFile("Map/prov.bmp");
+	auto prov_txt = ReadFile("Map/prov.txt");
+	auto scenario = ReadFile("UserData/Nation");
+	if (map_bmp.size() < 54 || prov_bmp.size() < 54 || prov_txt.empty())
+	{
+		fprintf(stderr, "Map/ not found; run from the repository root\n");
+		return 1;
+	}
+
+	Simulation sim(seed);
+	sim.ai.budget_us = ai_budget;
+	sim.ai.threads = ai_threads;
+	sim.LoadNations();
+	sim.LoadMap(DecodeCP949(prov_txt), map_bmp, prov_bmp);
+	sim.PrepareDistances("Map/path.cache");
+	if (hierarchy) sim.PrepareHierarchy("Map/path.ch");
+	sim.LoadScenario(DecodeCP949(scenario));
+	for (const auto& line : sim.log) fprintf(stderr, "%s\n", line.c_str());
+
+	auto begin = std::chrono::steady_clock::now();
+	sim.Step(ticks);
+	auto end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - begin).count();
+
+	// Cheap fingerprint of the final state to compare runs with the same seed.
+	std::uint64_t hash = 1469598103934665603ull;
+	auto mix = [&hash](std::uint64_t v) { hash = (hash ^ v) * 1099511628211ull; };
+	const auto& Prov = sim.data->province;
+	for (ProvinceId P : Prov.ids())
+	{
+		mix(P);
+		mix(Prov.owner[P]);
+		mix(Prov.ruler[P]);
+		mix((std::uint64_t)Prov.Man(P, sim.data->tick));
+		mix((std::uint64_t)Prov.Hp(P, sim.data->tick));
+	}
+	mix(sim.data->leaders.size());
+	mix(sim.data->leader_progress);
+
+	printf("seed %u, %llu ticks in %.3f s (%.1f ticks/s)\n", seed, (unsigned long long)ticks, seconds, ticks / seconds);
+	printf("provinces %zu (%zu awake), nations %zu, leaders %zu, drafted %llu\n", sim.data->province.size(), sim.data->awake.size(), sim.data->nations.size(), sim.data->leaders.size(), (unsigned long long)(sim.data->leader_progress - 1));
+	printf("flow fields %zu live, %llu hits, %llu misses, %llu built, %llu repaired, %llu evicted\n", sim.data->flows.size(), (unsigned long long)sim.data->flows.hits, (unsigned long long)sim.data->flows.misses, (unsigned long long)sim.data->flows.builds, (unsigned long long)sim.data->flows.repairs, (unsigned long long)sim.data->flows.evictions);
+	printf("path cache %llu hits, %llu misses, %llu evicted\n", (unsigned long long)sim.data->paths.hits, (unsigned long long)sim.data->paths.misses, (unsigned long long)sim.data->paths.evictions);
+	printf("frontiers %llu hits, %llu misses, %llu repaired\n", (unsigned long long)sim.data->frontiers.hits, (unsigned long long)sim.data->frontiers.misses, (unsigned long long)sim.data->frontiers.repairs);
+	printf("influence %zu layers, %llu spreads, %llu pushed\n", sim.data->influence.layers(), (unsigned long long)sim.data->influence.spreads, (unsigned long long)sim.data->influence.pushes);
+	std::uint64_t plans = 0, worst_wait = 0;
+	double plan_us = 0, worst_us = 0;
+	for (const auto& L : sim.ai.latency())
+	{
+		plans += L.second.plans;
+		plan_us += L.second.total_us;
+		worst_us = std::max(worst_us, L.second.max_us);
+		worst_wait = std::max(worst_wait, L.second.max_wait);
+	}
+	printf("ai %llu plans, %.1f us mean, %.1f us worst, %llu ticks worst wait\n", (unsigned long long)plans, plans ? plan_us / plans : 0.0, worst_us, (unsigned long long)worst_wait);
+	printf("state %016llx\n", (unsigned long long)hash);
+	return 0;
+}
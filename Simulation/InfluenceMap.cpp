@@ -0,0 +1,119 @@
+#include "InfluenceMap.h"
+
+#include <algorithm>
+
+void InfluenceMap::Put(Layer& L, ProvinceId p, std::int64_t strength)
+{
+	if (p >= L.raw.size()) L.raw.resize(p + 1, 0);
+	L.raw[p] += strength;
+	if (!L.spread) return;
+	if (p >= L.sum.size())
+	{
+		L.sum.resize(p + 1, 0.0);
+		L.field.resize(p + 1, 0.f);
+	}
+	++pushes;
+	Push(L, p, (double)strength, 0);
+}
+
+// Province q gathers from the provinces its edges lead to, so a change at p reaches
+// q through every in-edge q -> p, scaled by Falloff / deg(q) for each step.
+void InfluenceMap::Push(Layer& L, ProvinceId p, double value, int depth)
+{
+	L.sum[p] += value;
+	L.field[p] = (float)L.sum[p];
+	if (depth == Passes) return;
+	for (std::uint32_t k = mGraph.InEdgeBegin(p); k < mGraph.InEdgeEnd(p); ++k)
+	{
+		const ProvinceId q = mGraph.from[k];
+		if (q != p) Push(L, q, value * Falloff * mInvDegree[q], depth + 1);
+	}
+}
+
+void InfluenceMap::Add(NationId owner, ProvinceId p, std::int64_t strength)
+{
+	if (strength == 0) return;
+	Sync();
+	mSize = std::max<size_t>(mSize, p + 1);
+	Put(mNations[owner], p, strength);
+	Put(mTotal, p, strength);
+}
+
+std::int64_t InfluenceMap::Raw(NationId owner, ProvinceId p) const
+{
+	auto N = mNations.find(owner);
+	return N != mNations.end() && p < N->second.raw.size() ? N->second.raw[p] : 0;
+}
+
+const std::vector<float>& InfluenceMap::Friendly(NationId owner)
+{
+	return Field(mNations[owner]);
+}
+
+const std::vector<float>& InfluenceMap::Total()
+{
+	return Field(mTotal);
+}
+
+void InfluenceMap::clear()
+{
+	mNations.clear();
+	mTotal = Layer();
+	mSize = 0;
+}
+
+void InfluenceMap::Sync()
+{
+	// The topology is fixed once the map is loaded, so this runs once.
+	const size_t m = mGraph.capacity();
+	if (mInvDegree.size() == m && mEdges == mGraph.edge_count()) return;
+
+	mEdges = mGraph.edge_count();
+	mInvDegree.assign(m, 0.0);
+	for (ProvinceId p = 0; p < m; ++p)
+	{
+		size_t degree = 0;
+		for (std::uint32_t e = mGraph.EdgeBegin(p); e < mGraph.EdgeEnd(p); ++e) degree += mGraph.to[e] != p;
+		if (degree) mInvDegree[p] = 1.0 / degree;
+	}
+	mGather.assign(m, 0.0);
+	for (auto& N : mNations) N.second.spread = false;
+	mTotal.spread = false;
+}
+
+const std::vector<float>& InfluenceMap::Field(Layer& L)
+{
+	Sync();
+	if (L.spread) return L.field;
+	++spreads;
+	L.spread = true;
+
+	const size_t n = std::max(mGraph.capacity(), mSize);
+	mBase.assign(n, 0.0);
+	for (size_t p = 0; p < L.raw.size(); ++p) mBase[p] = (double)L.raw[p];
+	L.sum = mBase;
+
+	double* gather = mGather.data();
+	double* sum = L.sum.data();
+	const double* base = mBase.data();
+	const double* inv = mInvDegree.data();
+	const size_t m = mGraph.capacity();
+	for (int pass = 0; pass < Passes; ++pass)
+	{
+		for (ProvinceId p = 0; p < m; ++p)
+		{
+			double s = 0.0;
+			for (std::uint32_t e = mGraph.offset[p]; e < mGraph.offset[p + 1]; ++e)
+			{
+				const ProvinceId q = mGraph.to[e];
+				s += q != p ? sum[q] : 0.0;
+			}
+			gather[p] = s;
+		}
+		for (size_t p = 0; p < m; ++p) sum[p] = base[p] + Falloff * gather[p] * inv[p];
+	}
+
+	L.field.resize(n);
+	for (size_t p = 0; p < n; ++p) L.field[p] = (float)L.sum[p];
+	return L.field;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "SimTypes.h"
+#include "ProvinceGraph.h"
+
+// Army strength per province and nation, counted where each leader's orders end, and
+// the same layers spread over the province graph so the AI can read how much of its
+// own or anyone else's strength is at or near a province without walking the
+// leaders.
+//
+// The raw layers are exact sums, kept by Data::PlaceLeader and EraseLeader as
+// leaders come and go, change size or change where their orders end.  A spread field
+// is Passes rounds of
+//     f[p] = raw[p] + Falloff * (sum of f over p's neighbours) / (their count)
+// each a gather over the CSR edges into a flat array and then a branch-free combine
+// the compiler vectorizes.  That full spread runs once, when a field is first read
+// (or the graph was rebuilt).  Spreading is linear, so afterwards every Add pushes
+// just its own change into the fields, which reaches no further than Passes steps
+// from the province; the same linearity makes a nation's threat simply
+// Total() - Friendly().
+class InfluenceMap
+{
+public:
+	static constexpr int Passes = 2;
+	static constexpr float Falloff = 0.25f;
+
+	explicit InfluenceMap(const ProvinceGraph& graph) : mGraph(graph) {}
+	InfluenceMap(const InfluenceMap& rhs) = delete;
+	InfluenceMap& operator=(const InfluenceMap& rhs) = delete;
+
+	// Adds strength (negative to take it away) to owner's layer at p.
+	void Add(NationId owner, ProvinceId p, std::int64_t strength);
+
+	std::int64_t Raw(NationId owner, ProvinceId p) const;
+	std::int64_t RawTotal(ProvinceId p) const { return p < mTotal.raw.size() ? mTotal.raw[p] : 0; }
+
+	// Spread fields, indexed by ProvinceId, covering every province of the graph.
+	// Kept up to date by every Add from then on.
+	const std::vector<float>& Friendly(NationId owner);
+	const std::vector<float>& Total();
+
+	size_t layers() const { return mNations.size(); }
+	void clear();
+
+	// Fields spread in full, and changes pushed into spread fields since.
+	std::uint64_t spreads = 0;
+	std::uint64_t pushes = 0;
+
+private:
+	struct Layer
+	{
+		std::vector<std::int64_t> raw;
+		// The field summed in double, so pushing changes in and out again does not
+		// drift, and what Friendly and Total hand out.
+		std::vector<double> sum;
+		std::vector<float> field;
+		bool spread = false;
+	};
+
+	void Put(Layer& L, ProvinceId p, std::int64_t strength);
+	// Adds value at p and carries it on to the provinces gathering from p, depth
+	// passes in.
+	void Push(Layer& L, ProvinceId p, double value, int depth);
+	const std::vector<float>& Field(Layer& L);
+	// Takes the degrees from the graph again, and drops every field, after it was
+	// rebuilt.
+	void Sync();
+
+	const ProvinceGraph& mGraph;
+	std::unordered_map<NationId, Layer> mNations;
+	Layer mTotal;
+	// One past the largest ProvinceId ever added to.
+	size_t mSize = 0;
+
+	std::vector<double> mBase;
+	std::vector<double> mGather;
+	std::vector<double> mInvDegree;
+	// Edge count mInvDegree was taken from.
+	size_t mEdges = 0;
+};
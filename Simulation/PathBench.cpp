@@ -0,0 +1,135 @@
+//***************************************************************************************
+// PathBench.cpp
+//
+// Times the province path queries on synthetic maps: a jittered grid of provinces
+// with some holes punched in it and random heights, weighted the way LoadMap weights
+// the real map.  Every query is checked against PathFinder::Find.
+//
+//   pathbench [--queries N] [--seed N] [sizes...]      (default sizes 1000 10000 50000)
+//***************************************************************************************
+
+#include "ProvinceStore.h"
+#include "ProvinceGraph.h"
+#include "PathFinder.h"
+#include "RegionGraph.h"
+#include "ContractionHierarchy.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double Seconds(Clock::time_point begin)
+	{
+		return std::chrono::duration<double>(Clock::now() - begin).count();
+	}
+
+	void MakeMap(size_t count, std::mt19937& mt, ProvinceStore& prov, ProvinceGraph& graph)
+	{
+		// About a tenth of the cells are holes, so size the grid a little larger.
+		const int side = (int)std::ceil(std::sqrt(count / 0.9));
+		std::vector<char> hole(side * side);
+		for (auto& H : hole) H = mt() % 10 == 0;
+
+		auto id = [side](int x, int y) { return (ProvinceId)(1 + x + y * side); };
+		std::vector<std::pair<ProvinceId, ProvinceId>> edges;
+		for (int y = 0; y < side; ++y)
+		{
+			for (int x = 0; x < side; ++x)
+			{
+				if (hole[x + y * side]) continue;
+				const ProvinceId O = id(x, y);
+				prov.Add(O, L"", 0, Float3());
+				prov.on3Dpos[O] = Float3(x * 4.f + (mt() % 100) / 50.f, (mt() % 100) / 20.f, y * 4.f + (mt() % 100) / 50.f);
+
+				const int dx[] = { 1, -1, 0, 0 }, dy[] = { 0, 0, 1, -1 };
+				for (int d = 0; d < 4; ++d)
+				{
+					const int X = x + dx[d], Y = y + dy[d];
+					if (X < 0 || Y < 0 || X >= side || Y >= side || hole[X + Y * side]) continue;
+					edges.push_back(std::make_pair(O, id(X, Y)));
+				}
+			}
+		}
+
+		graph.Build(prov.capacity(), std::move(edges));
+		graph.Reweight([&prov](ProvinceId O, ProvinceId P)
+		{
+			const Float3& A = prov.on3Dpos[O];
+			const Float3& B = prov.on3Dpos[P];
+			return sqrtf((A.x - B.x) * (A.x - B.x) + (A.z - B.z) * (A.z - B.z)) + std::max(B.y - A.y, 0.f);
+		});
+	}
+
+	bool Same(const ProvincePath& expect, const ProvincePath& got)
+	{
+		if (expect.length == FLT_MAX || got.length == FLT_MAX) return expect.length == got.length;
+		return std::fabs(expect.length - got.length) <= 1e-4f * std::max(1.f, expect.length);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t queries = 2000;
+	std::uint32_t seed = 1;
+	std::vector<size_t> sizes;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--queries") && i + 1 < argc) queries = std::stoul(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (std::uint32_t)std::stoul(argv[++i]);
+		else sizes.push_back(std::stoul(argv[i]));
+	}
+	if (sizes.empty()) sizes = { 1000, 10000, 50000 };
+
+	printf("%8s %12s %12s %12s %12s %10s %10s %9s\n", "provs", "ProvPath us", "Find us", "Region us", "CH us", "Region ms", "CH ms", "mismatch");
+	for (size_t count : sizes)
+	{
+		std::mt19937 mt(seed);
+		ProvinceStore prov;
+		ProvinceGraph graph;
+		MakeMap(count, mt, prov, graph);
+
+		const auto& ids = prov.ids();
+		std::vector<std::pair<ProvinceId, ProvinceId>> pairs(queries);
+		for (auto& Q : pairs) Q = std::make_pair(ids[mt() % ids.size()], ids[mt() % ids.size()]);
+
+		auto begin = Clock::now();
+		RegionGraph regions(prov, graph);
+		regions.Build();
+		const double region_build = Seconds(begin);
+
+		begin = Clock::now();
+		ContractionHierarchy hierarchy;
+		hierarchy.Build(graph, 0);
+		const double ch_build = Seconds(begin);
+
+		std::vector<ProvincePath> expect(queries);
+		begin = Clock::now();
+		for (size_t i = 0; i < queries; ++i) expect[i] = ProvincePath(prov, graph, pairs[i].first, pairs[i].second);
+		const double one_off = Seconds(begin);
+
+		PathFinder finder(prov, graph);
+		begin = Clock::now();
+		for (size_t i = 0; i < queries; ++i) finder.Find(pairs[i].first, pairs[i].second, NoNation);
+		const double find = Seconds(begin);
+
+		size_t mismatch = 0;
+		begin = Clock::now();
+		for (size_t i = 0; i < queries; ++i) mismatch += !Same(expect[i], regions.Find(pairs[i].first, pairs[i].second));
+		const double region = Seconds(begin);
+
+		begin = Clock::now();
+		for (size_t i = 0; i < queries; ++i) mismatch += !Same(expect[i], hierarchy.Path(pairs[i].first, pairs[i].second));
+		const double ch = Seconds(begin);
+
+		const double us = 1e6 / queries;
+		printf("%8zu %12.1f %12.1f %12.1f %12.1f %10.1f %10.1f %9zu\n", prov.size(), one_off * us, find * us, region * us, ch * us, region_build * 1e3, ch_build * 1e3, mismatch);
+	}
+	return 0;
+}
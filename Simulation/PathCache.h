@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "SimTypes.h"
+#include "PathFinder.h"
+
+// Least-recently-used cache of point-to-point paths keyed by (start, end, mover,
+// graph epoch).  Any cost change bumps the epoch, so stale paths can never be
+// returned; they simply stop being asked for and age out.
+class PathCache
+{
+public:
+	explicit PathCache(size_t capacity = 1024) : mCapacity(capacity) {}
+
+	// nullptr on a miss.  A hit becomes the most recently used entry.
+	const ProvincePath* Find(ProvinceId start, ProvinceId end, NationId mover, std::uint64_t epoch)
+	{
+		auto O = mIndex.find(Key{ start, end, mover, epoch });
+		if (O == mIndex.end())
+		{
+			++misses;
+			return nullptr;
+		}
+		++hits;
+		mEntries.splice(mEntries.begin(), mEntries, O->second);
+		return &O->second->second;
+	}
+
+	const ProvincePath& Insert(ProvinceId start, ProvinceId end, NationId mover, std::uint64_t epoch, ProvincePath path)
+	{
+		const Key key{ start, end, mover, epoch };
+		if (auto O = mIndex.find(key); O != mIndex.end())
+		{
+			O->second->second = std::move(path);
+			mEntries.splice(mEntries.begin(), mEntries, O->second);
+			return O->second->second;
+		}
+
+		while (!mEntries.empty() && mEntries.size() >= mCapacity)
+		{
+			mIndex.erase(mEntries.back().first);
+			mEntries.pop_back();
+			++evictions;
+		}
+		mEntries.emplace_front(key, std::move(path));
+		mIndex.emplace(key, mEntries.begin());
+		return mEntries.front().second;
+	}
+
+	void clear()
+	{
+		mEntries.clear();
+		mIndex.clear();
+	}
+
+	size_t size() const { return mEntries.size(); }
+	size_t capacity() const { return mCapacity; }
+
+	std::uint64_t hits = 0;
+	std::uint64_t misses = 0;
+	std::uint64_t evictions = 0;
+
+private:
+	struct Key
+	{
+		ProvinceId start;
+		ProvinceId end;
+		NationId mover;
+		std::uint64_t epoch;
+		bool operator==(const Key& rhs) const { return start == rhs.start && end == rhs.end && mover == rhs.mover && epoch == rhs.epoch; }
+	};
+	struct KeyHash
+	{
+		size_t operator()(const Key& K) const
+		{
+			std::uint64_t h = K.start * 0x9E3779B97F4A7C15ull;
+			h ^= K.end + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+			h ^= K.mover + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+			h ^= K.epoch + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+			return (size_t)h;
+		}
+	};
+
+	size_t mCapacity;
+	// Most recently used first.
+	std::list<std::pair<Key, ProvincePath>> mEntries;
+	std::unordered_map<Key, decltype(mEntries)::iterator, KeyHash> mIndex;
+};
@@ -0,0 +1,296 @@
+#include "PathFinder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+ProvincePath::ProvincePath(const ProvinceStore& _prv, const ProvinceGraph& conn, const ProvinceId& Start, const ProvinceId& End, NationId mover)
+{
+	*this = PathFinder(_prv, conn).Find(Start, End, mover);
+}
+
+float PathFinder::Heuristic(ProvinceId from, ProvinceId goal) const
+{
+	const Float3& A = mProv.on3Dpos[from];
+	const Float3& B = mProv.on3Dpos[goal];
+	// Shaved a little so float rounding can never push it above the real edge weight.
+	return 0.999f * sqrtf((A.x - B.x) * (A.x - B.x) + (A.z - B.z) * (A.z - B.z));
+}
+
+void PathFinder::Reset()
+{
+	const size_t n = mGraph.capacity();
+	if (mSeen.size() != n)
+	{
+		mSeen.assign(n, 0);
+		mClosed.assign(n, 0);
+		mDist.assign(n, FLT_MAX);
+		mNext.assign(n, 0);
+		mSearch = 0;
+	}
+	if (++mSearch == 0)
+	{
+		std::fill(mSeen.begin(), mSeen.end(), 0);
+		std::fill(mClosed.begin(), mClosed.end(), 0);
+		mSearch = 1;
+	}
+	mHeap.clear();
+}
+
+ProvincePath PathFinder::Find(ProvinceId Start, ProvinceId End, NationId mover)
+{
+	ProvincePath R;
+	if (Start == End) return R;
+
+	R.length = FLT_MAX;
+	if (Start >= mGraph.capacity() || End >= mGraph.capacity() || Start >= mProv.capacity() || End >= mProv.capacity()) return R;
+
+	Reset();
+	const auto cmp = std::greater<std::pair<float, ProvinceId>>();
+
+	mSeen[End] = mSearch;
+	mDist[End] = 0;
+	mHeap.push_back(std::make_pair(Heuristic(End, Start), End));
+
+	while (!mHeap.empty())
+	{
+		std::pop_heap(mHeap.begin(), mHeap.end(), cmp);
+		const ProvinceId O = mHeap.back().second;
+		mHeap.pop_back();
+
+		if (mClosed[O] == mSearch) continue;
+		mClosed[O] = mSearch;
+		if (O == Start) break;
+
+		for (std::uint32_t e = mGraph.EdgeBegin(O); e < mGraph.EdgeEnd(O); ++e)
+		{
+			const ProvinceId P = mGraph.to[e];
+			if (mClosed[P] == mSearch) continue;
+
+			const float d = mDist[O] + mGraph.Cost(e, O, mover);
+			if (mSeen[P] != mSearch || d < mDist[P])
+			{
+				mSeen[P] = mSearch;
+				mDist[P] = d;
+				mNext[P] = O;
+				mHeap.push_back(std::make_pair(d + Heuristic(P, Start), P));
+				std::push_heap(mHeap.begin(), mHeap.end(), cmp);
+			}
+		}
+	}
+
+	if (mClosed[Start] != mSearch) return R;
+
+	R.length = mDist[Start];
+	for (ProvinceId Index = Start; Index != End;)
+	{
+		Index = mNext[Index];
+		R.path.push_back(Index);
+	}
+	return R;
+}
+
+void PathFinder::Flood(ProvinceId End, NationId mover, float* dist, std::uint32_t* next)
+{
+	Flood(&End, 1, mover, dist, next);
+}
+
+void PathFinder::Flood(const ProvinceId* Ends, size_t count, NationId mover, float* dist, std::uint32_t* next)
+{
+	const size_t n = mGraph.capacity();
+	std::fill(dist, dist + n, FLT_MAX);
+	std::fill(next, next + n, 0);
+
+	Reset();
+	const auto cmp = std::greater<std::pair<float, ProvinceId>>();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const ProvinceId End = Ends[i];
+		if (End >= n || mSeen[End] == mSearch) continue;
+		mSeen[End] = mSearch;
+		mDist[End] = 0;
+		mNext[End] = End;
+		mHeap.push_back(std::make_pair(0.f, End));
+	}
+	std::make_heap(mHeap.begin(), mHeap.end(), cmp);
+
+	while (!mHeap.empty())
+	{
+		std::pop_heap(mHeap.begin(), mHeap.end(), cmp);
+		const ProvinceId O = mHeap.back().second;
+		mHeap.pop_back();
+
+		if (mClosed[O] == mSearch) continue;
+		mClosed[O] = mSearch;
+		dist[O] = mDist[O];
+		next[O] = (std::uint32_t)mNext[O];
+
+		for (std::uint32_t e = mGraph.EdgeBegin(O); e < mGraph.EdgeEnd(O); ++e)
+		{
+			const ProvinceId P = mGraph.to[e];
+			if (mClosed[P] == mSearch) continue;
+
+			const float d = mDist[O] + mGraph.Cost(e, O, mover);
+			if (mSeen[P] != mSearch || d < mDist[P])
+			{
+				mSeen[P] = mSearch;
+				mDist[P] = d;
+				mNext[P] = O;
+				mHeap.push_back(std::make_pair(d, P));
+				std::push_heap(mHeap.begin(), mHeap.end(), cmp);
+			}
+		}
+	}
+}
+
+void PathFinder::Repair(const ProvinceId* changed, size_t count, NationId mover, float* dist, std::uint32_t* next)
+{
+	const size_t n = mGraph.capacity();
+	Reset();
+	const auto cmp = std::greater<std::pair<float, ProvinceId>>();
+
+	// A province loses its value when the edge to its parent got dearer, and so does
+	// everything below it in the tree.  mSeen marks them.
+	mAffected.clear();
+	auto lose = [&](ProvinceId x)
+	{
+		if (mSeen[x] == mSearch || dist[x] == FLT_MAX) return;
+		mSeen[x] = mSearch;
+		mAffected.push_back(x);
+	};
+	for (size_t i = 0; i < count; ++i)
+	{
+		const ProvinceId b = changed[i];
+		if (b >= n || dist[b] == FLT_MAX) continue;
+		for (std::uint32_t e = mGraph.EdgeBegin(b); e < mGraph.EdgeEnd(b); ++e)
+		{
+			const ProvinceId x = mGraph.to[e];
+			if (x != b && next[x] == b && dist[b] + mGraph.Cost(e, b, mover) > dist[x]) lose(x);
+		}
+	}
+	for (size_t i = 0; i < mAffected.size(); ++i)
+	{
+		const ProvinceId u = mAffected[i];
+		for (std::uint32_t e = mGraph.EdgeBegin(u); e < mGraph.EdgeEnd(u); ++e)
+			if (const ProvinceId y = mGraph.to[e]; y != u && next[y] == u) lose(y);
+	}
+
+	// Reopen them from their best neighbour that kept its value.
+	for (ProvinceId u : mAffected)
+	{
+		dist[u] = FLT_MAX;
+		next[u] = 0;
+	}
+	for (ProvinceId u : mAffected)
+	{
+		for (std::uint32_t k = mGraph.InEdgeBegin(u); k < mGraph.InEdgeEnd(u); ++k)
+		{
+			const ProvinceId b = mGraph.from[k];
+			if (mSeen[b] == mSearch || dist[b] == FLT_MAX) continue;
+			if (const float d = dist[b] + mGraph.Cost(mGraph.in_edge[k], b, mover); d < dist[u])
+			{
+				dist[u] = d;
+				next[u] = (std::uint32_t)b;
+			}
+		}
+		if (dist[u] != FLT_MAX) mHeap.push_back(std::make_pair(dist[u], u));
+	}
+
+	// Edges that got cheaper can only improve their targets.
+	for (size_t i = 0; i < count; ++i)
+	{
+		const ProvinceId b = changed[i];
+		if (b >= n || dist[b] == FLT_MAX) continue;
+		for (std::uint32_t e = mGraph.EdgeBegin(b); e < mGraph.EdgeEnd(b); ++e)
+		{
+			const ProvinceId x = mGraph.to[e];
+			if (const float d = dist[b] + mGraph.Cost(e, b, mover); d < dist[x])
+			{
+				dist[x] = d;
+				next[x] = (std::uint32_t)b;
+				mHeap.push_back(std::make_pair(d, x));
+			}
+		}
+	}
+	std::make_heap(mHeap.begin(), mHeap.end(), cmp);
+
+	while (!mHeap.empty())
+	{
+		std::pop_heap(mHeap.begin(), mHeap.end(), cmp);
+		const auto [d, O] = mHeap.back();
+		mHeap.pop_back();
+		if (d > dist[O]) continue;
+
+		for (std::uint32_t e = mGraph.EdgeBegin(O); e < mGraph.EdgeEnd(O); ++e)
+		{
+			const ProvinceId P = mGraph.to[e];
+			if (const float nd = d + mGraph.Cost(e, O, mover); nd < dist[P])
+			{
+				dist[P] = nd;
+				next[P] = (std::uint32_t)O;
+				mHeap.push_back(std::make_pair(nd, P));
+				std::push_heap(mHeap.begin(), mHeap.end(), cmp);
+			}
+		}
+	}
+}
+
+void PathFinder::Field(ProvinceId Start, NationId mover, DistanceField& field)
+{
+	const size_t n = mGraph.capacity();
+	field.source = Start;
+	field.mover = mover;
+	field.epoch = mGraph.epoch;
+	field.dist.assign(n, FLT_MAX);
+	field.parent.assign(n, 0);
+	if (Start >= n) return;
+
+	Reset();
+	const auto cmp = std::greater<std::pair<float, ProvinceId>>();
+
+	mSeen[Start] = mSearch;
+	mDist[Start] = 0;
+	mHeap.push_back(std::make_pair(0.f, Start));
+
+	while (!mHeap.empty())
+	{
+		std::pop_heap(mHeap.begin(), mHeap.end(), cmp);
+		const ProvinceId O = mHeap.back().second;
+		mHeap.pop_back();
+
+		if (mClosed[O] == mSearch) continue;
+		mClosed[O] = mSearch;
+		field.dist[O] = mDist[O];
+		field.parent[O] = O == Start ? 0 : mNext[O];
+
+		for (std::uint32_t k = mGraph.InEdgeBegin(O); k < mGraph.InEdgeEnd(O); ++k)
+		{
+			const ProvinceId P = mGraph.from[k];
+			if (mClosed[P] == mSearch) continue;
+
+			const float d = mDist[O] + mGraph.Cost(mGraph.in_edge[k], P, mover);
+			if (mSeen[P] != mSearch || d < mDist[P])
+			{
+				mSeen[P] = mSearch;
+				mDist[P] = d;
+				mNext[P] = O;
+				mHeap.push_back(std::make_pair(d, P));
+				std::push_heap(mHeap.begin(), mHeap.end(), cmp);
+			}
+		}
+	}
+}
+
+ProvincePath DistanceField::PathTo(ProvinceId target) const
+{
+	ProvincePath R;
+	if (target == source) return R;
+
+	R.length = Distance(target);
+	if (R.length == FLT_MAX) return R;
+
+	for (ProvinceId Index = target; Index != source; Index = parent[Index])
+		R.path.push_front(Index);
+	return R;
+}
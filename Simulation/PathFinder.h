@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <list>
+#include <utility>
+#include <vector>
+
+#include "SimTypes.h"
+#include "ProvinceStore.h"
+#include "ProvinceGraph.h"
+
+struct ProvincePath
+{
+	// Provinces to walk through after Start, ending with End.  Empty when Start == End
+	// or End cannot be reached.
+	std::list<ProvinceId> path;
+	// 0 when Start == End, FLT_MAX when End cannot be reached.
+	float length = 0;
+	decltype(path)::iterator begin() { return path.begin(); }
+	decltype(path)::iterator end() { return path.end(); }
+
+	// One-off search with its own scratch; the tick uses Data::pathfinder instead.
+	ProvincePath(const ProvinceStore& _prv, const ProvinceGraph& conn, const ProvinceId& Start, const ProvinceId& End, NationId mover = NoNation);
+	ProvincePath()
+	{
+
+	};
+};
+
+// Path lengths from one province to every other, as filled by PathFinder::Field.
+struct DistanceField
+{
+	ProvinceId source = 0;
+	// Whose tolls it was computed with, and the ProvinceGraph::epoch it was computed at.
+	NationId mover = NoNation;
+	std::uint64_t epoch = 0;
+	// FLT_MAX where unreachable.
+	std::vector<float> dist;
+	// Previous province on the way from source; 0 for source and unreachable ones.
+	std::vector<ProvinceId> parent;
+
+	float Distance(ProvinceId p) const { return p < dist.size() ? dist[p] : FLT_MAX; }
+	ProvincePath PathTo(ProvinceId target) const;
+};
+
+// A* over the province graph with a binary heap and scratch buffers that are reused
+// between searches.  The search grows from End, so a province's cost is the sum of
+// weight(next, province) along the way, which is what ProvincePath has always used.
+// The heuristic is the straight-line ground distance between on3Dpos, which never
+// exceeds an edge weight (width + climb), so the first time Start settles its
+// distance is final and the search stops there.
+//
+// Every search is for one mover and adds the tolls it pays (ProvinceGraph::Cost);
+// NoNation searches the geometric weights alone.
+class PathFinder
+{
+public:
+	PathFinder(const ProvinceStore& prov, const ProvinceGraph& graph) : mProv(prov), mGraph(graph) {}
+	PathFinder(const PathFinder& rhs) = delete;
+	PathFinder& operator=(const PathFinder& rhs) = delete;
+
+	ProvincePath Find(ProvinceId Start, ProvinceId End, NationId mover);
+
+	// Plain Dijkstra from End to every province.  dist[p] is the length of
+	// Find(p, End) (FLT_MAX when unreachable) and next[p] the first province on that
+	// path; both must hold mGraph.capacity() entries.
+	void Flood(ProvinceId End, NationId mover, float* dist, std::uint32_t* next);
+	// Same with several goals at once: dist[p] is the length to the nearest of them
+	// and next[p] the first step towards it.
+	void Flood(const ProvinceId* Ends, size_t count, NationId mover, float* dist, std::uint32_t* next);
+	// Brings dist/next from an earlier Flood for the same mover up to date after the
+	// tolls of the changed provinces moved (ProvinceGraph::SetToll), in the manner of
+	// LPA*: only provinces whose path got dearer are reopened, only improvements are
+	// pushed, and the search stops where the old values still hold.
+	void Repair(const ProvinceId* changed, size_t count, NationId mover, float* dist, std::uint32_t* next);
+
+	// Dijkstra outwards from Start along the in-edges, so field.Distance(p) equals
+	// Find(Start, p, mover).length for every p.  One call answers a whole "which
+	// province is worth walking to" scan.
+	void Field(ProvinceId Start, NationId mover, DistanceField& field);
+
+private:
+	float Heuristic(ProvinceId from, ProvinceId goal) const;
+	void Reset();
+
+	const ProvinceStore& mProv;
+	const ProvinceGraph& mGraph;
+
+	// A slot is valid for the current search only when its stamp matches mSearch,
+	// so nothing has to be cleared between searches.
+	std::uint32_t mSearch = 0;
+	std::vector<std::uint32_t> mSeen;
+	std::vector<std::uint32_t> mClosed;
+	std::vector<float> mDist;
+	std::vector<ProvinceId> mNext;
+	std::vector<std::pair<float, ProvinceId>> mHeap;
+	std::vector<ProvinceId> mAffected;
+};
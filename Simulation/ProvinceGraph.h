@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "SimTypes.h"
+
+// Province adjacency in compressed sparse row form.  The out-edges of province p are
+// to[offset[p]] .. to[offset[p + 1] - 1], sorted by target id, with the matching
+// costs in weight[].  The topology is fixed once the map is loaded.
+//
+// weight[e] is the geometric cost, set by Reweight(), and does not change while the
+// game runs.  On top of it every province carries a toll, set by SetToll(), which
+// Cost() adds to the edges leaving it for any mover but the nation exempt from it.
+// Paths are measured against the edges (see PathFinder), so a toll on p is paid by
+// every step that walks into p.  Tolls change while the game runs; each change is
+// logged so caches can repair just what it touched instead of starting over.
+//
+// The reverse view lists the in-edges of p as in_edge[in_offset[p]] ..
+// in_edge[in_offset[p + 1] - 1], each an index into to/weight, with the source
+// province in from[], so searches that run against the edges share the same costs.
+class ProvinceGraph
+{
+public:
+	std::vector<std::uint32_t> offset;
+	std::vector<ProvinceId> to;
+	std::vector<float> weight;
+	std::vector<float> toll;
+	std::vector<NationId> exempt;
+
+	std::vector<std::uint32_t> in_offset;
+	std::vector<ProvinceId> from;
+	std::vector<std::uint32_t> in_edge;
+
+	// Bumped whenever the topology, a weight or a toll changes, so cached search
+	// results can tell they are stale.
+	std::uint64_t epoch = 0;
+	// The epoch of the last Build or Reweight.  Results that ignore the tolls only go
+	// stale when this moves.
+	std::uint64_t weight_epoch = 0;
+
+	// Provinces whose toll changed, with the epoch each change produced, oldest
+	// first.  Covers every change after log_start; Build and Reweight reset it.
+	std::vector<std::pair<std::uint64_t, ProvinceId>> changes;
+	std::uint64_t log_start = 0;
+	static constexpr size_t MaxChanges = 4096;
+
+	// capacity is one past the largest ProvinceId.  Duplicate edges are dropped and
+	// every weight starts at FLT_MAX.
+	void Build(size_t capacity, std::vector<std::pair<ProvinceId, ProvinceId>> edges)
+	{
+		++epoch;
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		for (const auto& E : edges)
+			capacity = std::max<size_t>(capacity, std::max(E.first, E.second) + 1);
+
+		offset.assign(capacity + 1, 0);
+		to.resize(edges.size());
+		weight.assign(edges.size(), FLT_MAX);
+		toll.assign(capacity, 0.f);
+		exempt.assign(capacity, NoNation);
+		changes.clear();
+		log_start = epoch;
+		weight_epoch = epoch;
+
+		for (const auto& E : edges) ++offset[E.first + 1];
+		for (size_t p = 0; p < capacity; ++p) offset[p + 1] += offset[p];
+		for (size_t e = 0; e < edges.size(); ++e) to[e] = edges[e].second;
+
+		in_offset.assign(capacity + 1, 0);
+		from.resize(edges.size());
+		in_edge.resize(edges.size());
+
+		for (const auto& E : edges) ++in_offset[E.second + 1];
+		for (size_t p = 0; p < capacity; ++p) in_offset[p + 1] += in_offset[p];
+		std::vector<std::uint32_t> fill(in_offset.begin(), in_offset.end() - 1);
+		for (size_t e = 0; e < edges.size(); ++e)
+		{
+			const std::uint32_t k = fill[edges[e].second]++;
+			from[k] = edges[e].first;
+			in_edge[k] = (std::uint32_t)e;
+		}
+	}
+
+	// Sets every weight; tolls are kept.
+	template <class Cost>
+	void Reweight(Cost cost)
+	{
+		++epoch;
+		changes.clear();
+		log_start = epoch;
+		weight_epoch = epoch;
+		for (ProvinceId p = 0; p + 1 < offset.size(); ++p)
+			for (std::uint32_t e = offset[p]; e < offset[p + 1]; ++e) weight[e] = cost(p, to[e]);
+	}
+
+	// who, typically the ruler of p, walks into it for free.
+	void SetToll(ProvinceId p, float value, NationId who)
+	{
+		if (p >= capacity() || (toll[p] == value && exempt[p] == who)) return;
+		toll[p] = value;
+		exempt[p] = who;
+
+		++epoch;
+		changes.push_back(std::make_pair(epoch, p));
+		if (changes.size() > MaxChanges)
+		{
+			log_start = changes[MaxChanges / 2 - 1].first;
+			changes.erase(changes.begin(), changes.begin() + MaxChanges / 2);
+		}
+	}
+
+	// Fills out with the provinces whose toll or exemption changed after epoch since,
+	// possibly with repeats.  False when the log no longer reaches back that far.
+	bool ChangedSince(std::uint64_t since, std::vector<ProvinceId>& out) const
+	{
+		out.clear();
+		if (since < log_start) return false;
+		auto O = std::upper_bound(changes.begin(), changes.end(), std::make_pair(since, ~ProvinceId(0)));
+		for (; O != changes.end(); ++O) out.push_back(O->second);
+		return true;
+	}
+
+	size_t capacity() const { return offset.empty() ? 0 : offset.size() - 1; }
+	size_t edge_count() const { return to.size(); }
+
+	std::uint32_t EdgeBegin(ProvinceId p) const { return p < capacity() ? offset[p] : 0; }
+	std::uint32_t EdgeEnd(ProvinceId p) const { return p < capacity() ? offset[p + 1] : 0; }
+	std::uint32_t InEdgeBegin(ProvinceId p) const { return p < capacity() ? in_offset[p] : 0; }
+	std::uint32_t InEdgeEnd(ProvinceId p) const { return p < capacity() ? in_offset[p + 1] : 0; }
+
+	// Toll mover pays for walking into p.  NoNation moves for nobody and pays none,
+	// which leaves the geometric costs alone.
+	float Toll(ProvinceId p, NationId mover) const
+	{
+		return mover == NoNation || exempt[p] == mover ? 0.f : toll[p];
+	}
+	// Cost of edge e, which leaves src, for mover.
+	float Cost(std::uint32_t e, ProvinceId src, NationId mover) const { return weight[e] + Toll(src, mover); }
+
+	// Hash of the topology and the weights, without the tolls, so an index stored on
+	// disk can tell whether it was built for this graph.
+	std::uint64_t Checksum() const
+	{
+		std::uint64_t h = 14695981039346656037ull;
+		auto mix = [&h](const void* data, size_t size)
+		{
+			for (size_t i = 0; i < size; ++i) h = (h ^ ((const unsigned char*)data)[i]) * 1099511628211ull;
+		};
+		mix(offset.data(), offset.size() * sizeof(offset[0]));
+		mix(to.data(), to.size() * sizeof(to[0]));
+		mix(weight.data(), weight.size() * sizeof(weight[0]));
+		return h;
+	}
+
+	// Geometric cost of the edge src -> dest, FLT_MAX when they are not adjacent.
+	float Weight(ProvinceId src, ProvinceId dest) const
+	{
+		for (std::uint32_t e = EdgeBegin(src); e < EdgeEnd(src); ++e)
+			if (to[e] == dest) return weight[e];
+		return FLT_MAX;
+	}
+
+	// Same, throwing when they are not adjacent.  This is what a move takes in ticks.
+	float at(ProvinceId src, ProvinceId dest) const
+	{
+		for (std::uint32_t e = EdgeBegin(src); e < EdgeEnd(src); ++e)
+			if (to[e] == dest) return weight[e];
+		throw std::out_of_range("ProvinceGraph::at");
+	}
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SimTypes.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+inline unsigned CountTrailingZeros(std::uint64_t w)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, w);
+	return (unsigned)index;
+#else
+	return (unsigned)__builtin_ctzll(w);
+#endif
+}
+
+// Calls fn(id) for every bit set in word(i), i < count, in ascending id order.  word
+// may combine several sets, e.g. [&](size_t i) { return A.word(i) | B.word(i); }.
+template <class Word, class Fn>
+void ForEachBit(size_t count, Word word, Fn fn)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		for (std::uint64_t w = word(i); w; w &= w - 1)
+			fn((ProvinceId)(i * 64 + CountTrailingZeros(w)));
+	}
+}
+
+template <class Word>
+size_t CountBits(size_t count, Word word)
+{
+	size_t n = 0;
+	for (size_t i = 0; i < count; ++i) n += std::bitset<64>(word(i)).count();
+	return n;
+}
+
+// ProvinceIds as one bit each, with the size kept as members come and go, so
+// membership and size are O(1) and the members can be walked a word at a time.
+class ProvinceSet
+{
+public:
+	bool contains(ProvinceId p) const { return p / 64 < mWords.size() && (mWords[p / 64] >> (p % 64) & 1); }
+	size_t size() const { return mSize; }
+	bool empty() const { return mSize == 0; }
+
+	void insert(ProvinceId p)
+	{
+		if (p / 64 >= mWords.size()) mWords.resize(p / 64 + 1, 0);
+		std::uint64_t& W = mWords[p / 64];
+		const std::uint64_t bit = 1ull << (p % 64);
+		if (W & bit) return;
+		W |= bit;
+		++mSize;
+	}
+	void erase(ProvinceId p)
+	{
+		if (!contains(p)) return;
+		mWords[p / 64] &= ~(1ull << (p % 64));
+		--mSize;
+	}
+	void clear()
+	{
+		mWords.clear();
+		mSize = 0;
+	}
+
+	size_t word_count() const { return mWords.size(); }
+	// 0 past the end, so sets of different lengths combine freely.
+	std::uint64_t word(size_t i) const { return i < mWords.size() ? mWords[i] : 0; }
+
+	template <class Fn>
+	void for_each(Fn fn) const
+	{
+		ForEachBit(mWords.size(), [this](size_t i) { return mWords[i]; }, fn);
+	}
+
+private:
+	std::vector<std::uint64_t> mWords;
+	size_t mSize = 0;
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "SimTypes.h"
+
+// Province state stored column-wise and indexed directly by ProvinceId.
+// Hot columns are streamed every tick by the economy and the AI; cold columns
+// (name, color, pixel sums, 3D position) are only read while loading and by the UI.
+// Slot 0 is never a province, so ProvinceId 0 keeps meaning "none".
+class ProvinceStore
+{
+public:
+	// Hot
+	std::vector<NationId> owner;
+	std::vector<NationId> ruler;
+	std::vector<std::int64_t> man;
+	std::vector<std::int64_t> maxman;
+	std::vector<std::int64_t> hp;
+	std::vector<std::int64_t> p_num;
+
+	// Lazy regeneration.  A quiet province is skipped by the tick: man and hp hold
+	// their values as of tick settled and are advanced in closed form by Man() and
+	// Hp(), with man drifting at rate 1 and then man_rate every tick.  Settle before
+	// writing either.
+	std::vector<std::uint8_t> quiet;
+	std::vector<float> man_rate;
+	std::vector<std::uint64_t> settled;
+
+	// Cold
+	std::vector<std::wstring> name;
+	std::vector<Color32> color;
+	std::vector<Float3> pixel;
+	std::vector<Float3> on3Dpos;
+	std::vector<std::uint8_t> is_rebel;
+	std::vector<float> length_from_contry_side;
+
+	// Registered ids in ascending order.
+	const std::vector<ProvinceId>& ids() const { return mIds; }
+	size_t size() const { return mIds.size(); }
+	// One past the largest id; every column has this many entries.
+	size_t capacity() const { return mExists.size(); }
+	bool contains(ProvinceId id) const { return id < mExists.size() && mExists[id]; }
+
+	std::int64_t Man(ProvinceId p, std::uint64_t now) const
+	{
+		return quiet[p] ? DriftFor(man[p], maxman[p], man_rate[p], now - settled[p]) : man[p];
+	}
+	std::int64_t Hp(ProvinceId p, std::uint64_t now) const
+	{
+		return quiet[p] ? RepairFor(hp[p], p_num[p], now - settled[p]) : hp[p];
+	}
+	void Settle(ProvinceId p, std::uint64_t now)
+	{
+		if (!quiet[p]) return;
+		man[p] = Man(p, now);
+		hp[p] = Hp(p, now);
+		settled[p] = now;
+	}
+
+	// One tick's drift of man towards maxman: a 1200th of the gap scaled by rate, at
+	// most 10 either way.
+	static std::int64_t Drift(std::int64_t man, std::int64_t maxman, double rate)
+	{
+		return (std::int64_t)std::round(std::min(std::max((maxman - man) / 1200.0 * rate, -10.0), 10.0));
+	}
+	// man after ticks quiet ticks.  The combined step of a tick is monotone in man, so
+	// it holds each value for one run of ticks; runs are found by bisection and there
+	// are at most a few dozen before the step reaches 0.
+	static std::int64_t DriftFor(std::int64_t man, std::int64_t maxman, double rate, std::uint64_t ticks)
+	{
+		auto step = [maxman, rate](std::int64_t m)
+		{
+			const std::int64_t a = Drift(m, maxman, 1.0);
+			return a + Drift(m + a, maxman, rate);
+		};
+		while (ticks > 0)
+		{
+			const std::int64_t s = step(man);
+			if (s == 0) break;
+
+			std::uint64_t lo = 1, hi = ticks;
+			while (lo < hi)
+			{
+				const std::uint64_t mid = lo + (hi - lo + 1) / 2;
+				if (step(man + (std::int64_t)(mid - 1) * s) == s) lo = mid;
+				else hi = mid - 1;
+			}
+			man += (std::int64_t)lo * s;
+			ticks -= lo;
+		}
+		return man;
+	}
+	// hp after ticks ticks: a negative hp is raised to 0, then it climbs by one a tick
+	// up to p_num.
+	static std::int64_t RepairFor(std::int64_t hp, std::int64_t p_num, std::uint64_t ticks)
+	{
+		if (ticks == 0) return hp;
+		if (hp >= p_num) return p_num;
+		if (hp < 0)
+		{
+			hp = 0;
+			--ticks;
+		}
+		return ticks >= (std::uint64_t)(p_num - hp) ? p_num : hp + (std::int64_t)ticks;
+	}
+
+	void Add(ProvinceId id, const std::wstring& _name, Color32 _color, const Float3& _pixel)
+	{
+		if (id >= mExists.size()) Resize(id + 1);
+
+		mExists[id] = 1;
+		mIds.insert(std::upper_bound(mIds.begin(), mIds.end(), id), id);
+
+		name[id] = _name;
+		color[id] = _color;
+		pixel[id] = _pixel;
+		p_num[id] = 1;
+	}
+
+private:
+	void Resize(size_t n)
+	{
+		mExists.resize(n, 0);
+
+		owner.resize(n, 0);
+		ruler.resize(n, 0);
+		man.resize(n, 1000);
+		maxman.resize(n, 4000);
+		hp.resize(n, 1000);
+		p_num.resize(n, 0);
+		quiet.resize(n, 0);
+		man_rate.resize(n, 0.f);
+		settled.resize(n, 0);
+
+		name.resize(n);
+		color.resize(n, 0);
+		pixel.resize(n);
+		on3Dpos.resize(n);
+		is_rebel.resize(n, 0);
+		length_from_contry_side.resize(n, 0.f);
+	}
+
+	std::vector<std::uint8_t> mExists;
+	std::vector<ProvinceId> mIds;
+};
@@ -0,0 +1,78 @@
+//***************************************************************************************
+// RegenCheck.cpp
+//
+// Checks the closed forms a quiet province is settled with, ProvinceStore::DriftFor and
+// RepairFor, against the tick's regeneration stepped one tick at a time.  Each case is
+// a random province run for a random number of ticks, compared at every power of two
+// and at the last tick.
+//
+//   regencheck [--cases N] [--seed N]      (default 20000 cases)
+//***************************************************************************************
+
+#include "ProvinceStore.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace
+{
+	// One tick of a quiet province as Simulation::Tick runs it: man drifts at rate 1
+	// and then at the ruler's rate, and hp climbs to p_num.
+	void Step(std::int64_t& man, std::int64_t maxman, float rate, std::int64_t& hp, std::int64_t p_num)
+	{
+		man += ProvinceStore::Drift(man, maxman, 1.0);
+		man += ProvinceStore::Drift(man, maxman, rate);
+		if (hp < 0) hp = 0;
+		else if (hp >= p_num) hp = p_num;
+		else hp += 1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t cases = 20000;
+	std::uint32_t seed = 1;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--cases") && i + 1 < argc) cases = std::stoul(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (std::uint32_t)std::stoul(argv[++i]);
+	}
+
+	const float rates[] = { 0.f, 0.2f, 1.f, 1.2f, 1.25f, 1.5f, 10.f };
+	std::mt19937 mt(seed);
+	size_t checks = 0, man_mismatch = 0, hp_mismatch = 0;
+	std::uint64_t steps = 0;
+	for (size_t c = 0; c < cases; ++c)
+	{
+		const std::int64_t maxman = 4000 + mt() % 40000;
+		const std::int64_t man0 = (std::int64_t)(mt() % 50000) - 2000;
+		const std::int64_t p_num = 1 + mt() % 3000;
+		const std::int64_t hp0 = (std::int64_t)(mt() % 3500) - 300;
+		const float rate = rates[mt() % 7];
+		// Half the cases are short, to cover the first runs of a drift closely.
+		const std::uint64_t ticks = mt() % 2 ? mt() % 64 : mt() % 4000;
+
+		std::int64_t man = man0, hp = hp0;
+		bool man_bad = false, hp_bad = false;
+		for (std::uint64_t t = 1; t <= ticks; ++t)
+		{
+			Step(man, maxman, rate, hp, p_num);
+			if ((t & (t - 1)) && t != ticks) continue;
+
+			++checks;
+			man_bad |= ProvinceStore::DriftFor(man0, maxman, rate, t) != man;
+			hp_bad |= ProvinceStore::RepairFor(hp0, p_num, t) != hp;
+		}
+		man_bad |= ProvinceStore::DriftFor(man0, maxman, rate, 0) != man0;
+		hp_bad |= ProvinceStore::RepairFor(hp0, p_num, 0) != hp0;
+		steps += ticks;
+		man_mismatch += man_bad;
+		hp_mismatch += hp_bad;
+	}
+
+	printf("%8s %10s %8s %13s %12s\n", "cases", "ticks", "checks", "man mismatch", "hp mismatch");
+	printf("%8zu %10llu %8zu %13zu %12zu\n", cases, (unsigned long long)steps, checks, man_mismatch, hp_mismatch);
+	return 0;
+}
@@ -0,0 +1,266 @@
+#include "RegionGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+void RegionGraph::Build(size_t region_size)
+{
+	mRegionSize = region_size;
+	mEpoch = mGraph.weight_epoch;
+
+	const size_t n = mGraph.capacity();
+	const size_t size = region_size ? region_size : std::max<size_t>(8, 4 * (size_t)std::sqrt((double)mProv.size()));
+
+	mRegion.assign(n, NoRegion);
+	mLocal.assign(n, 0);
+	mRegions.clear();
+
+	// Breadth-first growth from the lowest unassigned id, across edges in either
+	// direction, until the region is full.
+	for (ProvinceId s : mProv.ids())
+	{
+		if (s >= n || mRegion[s] != NoRegion) continue;
+
+		const std::uint32_t r = (std::uint32_t)mRegions.size();
+		mRegions.emplace_back();
+		auto& members = mRegions.back().members;
+		members.push_back(s);
+		mRegion[s] = r;
+
+		auto grow = [&](ProvinceId P)
+		{
+			if (members.size() >= size || mRegion[P] != NoRegion || !mProv.contains(P)) return;
+			mRegion[P] = r;
+			members.push_back(P);
+		};
+		for (size_t head = 0; head < members.size() && members.size() < size; ++head)
+		{
+			const ProvinceId O = members[head];
+			for (std::uint32_t e = mGraph.EdgeBegin(O); e < mGraph.EdgeEnd(O); ++e) grow(mGraph.to[e]);
+			for (std::uint32_t k = mGraph.InEdgeBegin(O); k < mGraph.InEdgeEnd(O); ++k) grow(mGraph.from[k]);
+		}
+		for (std::uint32_t i = 0; i < members.size(); ++i) mLocal[members[i]] = i;
+	}
+
+	mPortal.clear();
+	mPortalRow.clear();
+	mPortalOf.assign(n, NoRegion);
+	for (std::uint32_t r = 0; r < mRegions.size(); ++r)
+	{
+		auto& R = mRegions[r];
+		R.portals.clear();
+		for (ProvinceId O : R.members)
+		{
+			bool portal = false;
+			for (std::uint32_t e = mGraph.EdgeBegin(O); e < mGraph.EdgeEnd(O) && !portal; ++e)
+				portal = RegionOf(mGraph.to[e]) != r && RegionOf(mGraph.to[e]) != NoRegion;
+			for (std::uint32_t k = mGraph.InEdgeBegin(O); k < mGraph.InEdgeEnd(O) && !portal; ++k)
+				portal = RegionOf(mGraph.from[k]) != r && RegionOf(mGraph.from[k]) != NoRegion;
+			if (!portal) continue;
+
+			mPortalOf[O] = (std::uint32_t)mPortal.size();
+			mPortalRow.push_back((std::uint32_t)R.portals.size());
+			R.portals.push_back((std::uint32_t)mPortal.size());
+			mPortal.push_back(O);
+		}
+
+		BuildTables(r);
+	}
+	BuildLinks();
+
+	mSeen.assign(mPortal.size(), 0);
+	mClosed.assign(mPortal.size(), 0);
+	mCost.assign(mPortal.size(), FLT_MAX);
+	mFrom.assign(mPortal.size(), NoRegion);
+	mSearch = 0;
+}
+
+void RegionGraph::BuildTables(std::uint32_t r)
+{
+	auto& R = mRegions[r];
+	const size_t m = R.members.size();
+	R.dist.assign(R.portals.size() * m, FLT_MAX);
+	R.next.assign(R.portals.size() * m, 0);
+	for (size_t j = 0; j < R.portals.size(); ++j)
+		LocalFlood(r, mPortal[R.portals[j]], &R.dist[j * m], &R.next[j * m]);
+}
+
+void RegionGraph::BuildLinks()
+{
+	// Abstract edges: to the other portals of the same region at the in-region cost,
+	// and across every edge that leaves the region.
+	mLinkOffset.assign(mPortal.size() + 1, 0);
+	mLinks.clear();
+	for (std::uint32_t i = 0; i < mPortal.size(); ++i)
+	{
+		const ProvinceId u = mPortal[i];
+		const auto& R = mRegions[mRegion[u]];
+		const size_t m = R.members.size();
+		for (size_t j = 0; j < R.portals.size(); ++j)
+		{
+			const float cost = R.dist[j * m + mLocal[u]];
+			if (R.portals[j] != i && cost != FLT_MAX) mLinks.push_back({ R.portals[j], cost });
+		}
+		for (std::uint32_t k = mGraph.InEdgeBegin(u); k < mGraph.InEdgeEnd(u); ++k)
+		{
+			const ProvinceId v = mGraph.from[k];
+			if (RegionOf(v) == mRegion[u] || RegionOf(v) == NoRegion) continue;
+			mLinks.push_back({ mPortalOf[v], mGraph.weight[mGraph.in_edge[k]] });
+		}
+		mLinkOffset[i + 1] = (std::uint32_t)mLinks.size();
+	}
+}
+
+float RegionGraph::Heuristic(ProvinceId from, ProvinceId goal) const
+{
+	const Float3& A = mProv.on3Dpos[from];
+	const Float3& B = mProv.on3Dpos[goal];
+	return 0.999f * sqrtf((A.x - B.x) * (A.x - B.x) + (A.z - B.z) * (A.z - B.z));
+}
+
+void RegionGraph::LocalFlood(std::uint32_t r, ProvinceId goal, float* dist, ProvinceId* next)
+{
+	const auto& R = mRegions[r];
+	auto& done = mDone;
+	auto& heap = mLocalHeap;
+	done.assign(R.members.size(), 0);
+	heap.clear();
+	const auto cmp = std::greater<std::pair<float, ProvinceId>>();
+
+	std::fill(dist, dist + R.members.size(), FLT_MAX);
+	dist[mLocal[goal]] = 0;
+	next[mLocal[goal]] = goal;
+	heap.push_back(std::make_pair(0.f, goal));
+
+	while (!heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end(), cmp);
+		const ProvinceId O = heap.back().second;
+		heap.pop_back();
+
+		if (done[mLocal[O]]) continue;
+		done[mLocal[O]] = 1;
+
+		for (std::uint32_t e = mGraph.EdgeBegin(O); e < mGraph.EdgeEnd(O); ++e)
+		{
+			const ProvinceId P = mGraph.to[e];
+			if (RegionOf(P) != r || done[mLocal[P]]) continue;
+
+			const float d = dist[mLocal[O]] + mGraph.weight[e];
+			if (d < dist[mLocal[P]])
+			{
+				dist[mLocal[P]] = d;
+				next[mLocal[P]] = O;
+				heap.push_back(std::make_pair(d, P));
+				std::push_heap(heap.begin(), heap.end(), cmp);
+			}
+		}
+	}
+}
+
+ProvincePath RegionGraph::Find(ProvinceId Start, ProvinceId End)
+{
+	ProvincePath R;
+	if (Start == End) return R;
+
+	R.length = FLT_MAX;
+	Refresh();
+	const std::uint32_t rs = RegionOf(Start);
+	const std::uint32_t re = RegionOf(End);
+	if (rs == NoRegion || re == NoRegion) return R;
+
+	const auto& RS = mRegions[rs];
+	const auto& RE = mRegions[re];
+	const size_t ms = RS.members.size();
+	mEndDist.resize(RE.members.size());
+	mEndNext.resize(RE.members.size());
+	LocalFlood(re, End, mEndDist.data(), mEndNext.data());
+
+	// best_from is the last portal of the best route, NoRegion for the direct one.
+	float best = rs == re ? mEndDist[mLocal[Start]] : FLT_MAX;
+	std::uint32_t best_from = NoRegion;
+
+	if (++mSearch == 0)
+	{
+		std::fill(mSeen.begin(), mSeen.end(), 0);
+		std::fill(mClosed.begin(), mClosed.end(), 0);
+		mSearch = 1;
+	}
+	mHeap.clear();
+	const auto cmp = std::greater<std::pair<float, std::uint32_t>>();
+	auto relax = [&](std::uint32_t i, float cost, std::uint32_t from)
+	{
+		if (mClosed[i] == mSearch || (mSeen[i] == mSearch && cost >= mCost[i])) return;
+		mSeen[i] = mSearch;
+		mCost[i] = cost;
+		mFrom[i] = from;
+		mHeap.push_back(std::make_pair(cost + Heuristic(mPortal[i], End), i));
+		std::push_heap(mHeap.begin(), mHeap.end(), cmp);
+	};
+
+	for (size_t j = 0; j < RS.portals.size(); ++j)
+		if (const float c = RS.dist[j * ms + mLocal[Start]]; c != FLT_MAX) relax(RS.portals[j], c, NoRegion);
+
+	while (!mHeap.empty())
+	{
+		std::pop_heap(mHeap.begin(), mHeap.end(), cmp);
+		const float f = mHeap.back().first;
+		const std::uint32_t i = mHeap.back().second;
+		mHeap.pop_back();
+
+		if (mClosed[i] == mSearch) continue;
+		mClosed[i] = mSearch;
+		if (f >= best) break;
+
+		const ProvinceId u = mPortal[i];
+		if (mRegion[u] == re)
+		{
+			if (const float t = mCost[i] + mEndDist[mLocal[u]]; t < best)
+			{
+				best = t;
+				best_from = i;
+			}
+		}
+		for (std::uint32_t l = mLinkOffset[i]; l < mLinkOffset[i + 1]; ++l)
+			relax(mLinks[l].to, mCost[i] + mLinks[l].cost, i);
+	}
+
+	if (best == FLT_MAX) return R;
+	R.length = best;
+
+	std::vector<std::uint32_t> chain;
+	for (std::uint32_t i = best_from; i != NoRegion; i = mFrom[i]) chain.push_back(i);
+	std::reverse(chain.begin(), chain.end());
+
+	// Walks the in-region next hops of portal row j of region r from cur to its portal.
+	ProvinceId cur = Start;
+	auto walk = [&](std::uint32_t r, std::uint32_t j)
+	{
+		const auto& G = mRegions[r];
+		const size_t m = G.members.size();
+		const ProvinceId goal = mPortal[G.portals[j]];
+		while (cur != goal)
+		{
+			cur = G.next[j * m + mLocal[cur]];
+			R.path.push_back(cur);
+		}
+	};
+
+	for (std::uint32_t i : chain)
+	{
+		const ProvinceId p = mPortal[i];
+		if (mRegion[p] == mRegion[cur]) walk(mRegion[p], mPortalRow[i]);
+		else
+		{
+			cur = p;
+			R.path.push_back(cur);
+		}
+	}
+	while (cur != End)
+	{
+		cur = mEndNext[mLocal[cur]];
+		R.path.push_back(cur);
+	}
+	return R;
+}
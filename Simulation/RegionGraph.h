@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "SimTypes.h"
+#include "ProvinceStore.h"
+#include "ProvinceGraph.h"
+#include "PathFinder.h"
+
+// Two-level view of the province graph for point-to-point queries on large maps.
+//
+// Provinces are grown into connected regions of about region_size members.  A
+// province with an edge into another region is a portal.  For every portal the
+// region keeps a search restricted to the region towards it, which gives both the
+// portal-to-portal costs of the abstract graph and the next hops to refine them.  A
+// query runs one region-sized search around End, A* over the portals, and
+// then expands the abstract route back into provinces.  Costs follow
+// PathFinder::Find with NoNation, so Find(a, b) matches
+// PathFinder::Find(a, b, NoNation).length: tolls are left to the caller.
+class RegionGraph
+{
+public:
+	RegionGraph(const ProvinceStore& prov, const ProvinceGraph& graph) : mProv(prov), mGraph(graph) {}
+	RegionGraph(const RegionGraph& rhs) = delete;
+	RegionGraph& operator=(const RegionGraph& rhs) = delete;
+
+	// Clusters the provinces and fills the region tables.  region_size 0 picks four
+	// times the square root of the province count.
+	void Build(size_t region_size = 0);
+	// Rebuilds when the graph was reweighted since the last Build.
+	void Refresh() { if (mEpoch != mGraph.weight_epoch) Build(mRegionSize); }
+
+	ProvincePath Find(ProvinceId Start, ProvinceId End);
+
+	bool empty() const { return mRegions.empty(); }
+	size_t region_count() const { return mRegions.size(); }
+	size_t portal_count() const { return mPortal.size(); }
+	// Region of p, NoRegion for ids that are not provinces.
+	std::uint32_t RegionOf(ProvinceId p) const { return p < mRegion.size() ? mRegion[p] : NoRegion; }
+
+	static constexpr std::uint32_t NoRegion = 0xFFFFFFFFu;
+
+private:
+	struct Region
+	{
+		std::vector<ProvinceId> members;
+		// Indexes into mPortal.
+		std::vector<std::uint32_t> portals;
+		// Row j holds, for every member (by local index), the in-region cost to
+		// portals[j] and the next member on the way.
+		std::vector<float> dist;
+		std::vector<ProvinceId> next;
+	};
+	struct Link
+	{
+		std::uint32_t to;
+		float cost;
+	};
+
+	// Dijkstra from goal over the out-edges, staying inside region r.  Results are
+	// written by local index.
+	void LocalFlood(std::uint32_t r, ProvinceId goal, float* dist, ProvinceId* next);
+	void BuildTables(std::uint32_t r);
+	void BuildLinks();
+	// Same bound as PathFinder's, so the portal search can run as A*.
+	float Heuristic(ProvinceId from, ProvinceId goal) const;
+
+	const ProvinceStore& mProv;
+	const ProvinceGraph& mGraph;
+	std::uint64_t mEpoch = 0;
+	size_t mRegionSize = 0;
+
+	std::vector<std::uint32_t> mRegion;
+	std::vector<std::uint32_t> mLocal;
+	std::vector<Region> mRegions;
+
+	// Portal provinces, their index in the owning region's portal list, and the
+	// abstract edges leaving each one in CSR form.
+	std::vector<ProvinceId> mPortal;
+	std::vector<std::uint32_t> mPortalRow;
+	std::vector<std::uint32_t> mPortalOf;
+	std::vector<std::uint32_t> mLinkOffset;
+	std::vector<Link> mLinks;
+
+	// Query scratch, stamped like PathFinder's.
+	std::uint32_t mSearch = 0;
+	std::vector<std::uint32_t> mSeen;
+	std::vector<std::uint32_t> mClosed;
+	std::vector<float> mCost;
+	std::vector<std::uint32_t> mFrom;
+	std::vector<std::pair<float, std::uint32_t>> mHeap;
+	std::vector<float> mEndDist;
+	std::vector<ProvinceId> mEndNext;
+	std::vector<char> mDone;
+	std::vector<std::pair<float, ProvinceId>> mLocalHeap;
+};
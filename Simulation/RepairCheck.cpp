@@ -0,0 +1,195 @@
+//***************************************************************************************
+// RepairCheck.cpp
+//
+// Checks PathFinder::Repair against a fresh PathFinder::Flood on a synthetic map (the
+// jittered grid of PathBench).  Every round moves the tolls and exemptions of a few
+// random provinces; single-goal and multi-goal fields for several movers are then
+// repaired from the graph's change log, as FlowFieldService and FrontierCache do, and
+// every distance and next hop is compared with a flood from scratch.
+//
+//   repaircheck [--rounds N] [--seed N] [sizes...]      (default sizes 3000)
+//***************************************************************************************
+
+#include "ProvinceStore.h"
+#include "ProvinceGraph.h"
+#include "PathFinder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double Seconds(Clock::time_point begin)
+	{
+		return std::chrono::duration<double>(Clock::now() - begin).count();
+	}
+
+	void MakeMap(size_t count, std::mt19937& mt, ProvinceStore& prov, ProvinceGraph& graph)
+	{
+		// About a tenth of the cells are holes, so size the grid a little larger.
+		const int side = (int)std::ceil(std::sqrt(count / 0.9));
+		std::vector<char> hole(side * side);
+		for (auto& H : hole) H = mt() % 10 == 0;
+
+		auto id = [side](int x, int y) { return (ProvinceId)(1 + x + y * side); };
+		std::vector<std::pair<ProvinceId, ProvinceId>> edges;
+		for (int y = 0; y < side; ++y)
+		{
+			for (int x = 0; x < side; ++x)
+			{
+				if (hole[x + y * side]) continue;
+				const ProvinceId O = id(x, y);
+				prov.Add(O, L"", 0, Float3());
+				prov.on3Dpos[O] = Float3(x * 4.f + (mt() % 100) / 50.f, (mt() % 100) / 20.f, y * 4.f + (mt() % 100) / 50.f);
+
+				const int dx[] = { 1, -1, 0, 0 }, dy[] = { 0, 0, 1, -1 };
+				for (int d = 0; d < 4; ++d)
+				{
+					const int X = x + dx[d], Y = y + dy[d];
+					if (X < 0 || Y < 0 || X >= side || Y >= side || hole[X + Y * side]) continue;
+					edges.push_back(std::make_pair(O, id(X, Y)));
+				}
+			}
+		}
+
+		graph.Build(prov.capacity(), std::move(edges));
+		graph.Reweight([&prov](ProvinceId O, ProvinceId P)
+		{
+			const Float3& A = prov.on3Dpos[O];
+			const Float3& B = prov.on3Dpos[P];
+			return sqrtf((A.x - B.x) * (A.x - B.x) + (A.z - B.z) * (A.z - B.z)) + std::max(B.y - A.y, 0.f);
+		});
+	}
+
+	// A field kept up to date by Repair, the way the caches keep theirs.
+	struct Field
+	{
+		std::vector<ProvinceId> goals;
+		NationId mover;
+		std::uint64_t epoch = 0;
+		std::vector<float> dist;
+		std::vector<std::uint32_t> next;
+	};
+
+	// Distances must agree; a next hop only has to be one of the best, since ties may
+	// be broken either way.
+	size_t Compare(const ProvinceGraph& graph, const Field& F, const std::vector<float>& dist)
+	{
+		size_t mismatch = 0;
+		for (ProvinceId p = 0; p < dist.size(); ++p)
+		{
+			const float a = F.dist[p], b = dist[p];
+			if (a == FLT_MAX || b == FLT_MAX)
+			{
+				mismatch += a != b;
+				continue;
+			}
+			if (std::fabs(a - b) > 1e-4f * std::max(1.f, b))
+			{
+				++mismatch;
+				continue;
+			}
+			if (b == 0) continue;
+			const ProvinceId q = F.next[p];
+			float step = FLT_MAX;
+			for (std::uint32_t e = graph.offset[q]; e < graph.offset[q + 1]; ++e)
+				if (graph.to[e] == p) step = graph.Cost(e, q, F.mover);
+			mismatch += step == FLT_MAX || std::fabs(dist[q] + step - b) > 1e-4f * std::max(1.f, b);
+		}
+		return mismatch;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t rounds = 300;
+	std::uint32_t seed = 1;
+	std::vector<size_t> sizes;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--rounds") && i + 1 < argc) rounds = std::stoul(argv[++i]);
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (std::uint32_t)std::stoul(argv[++i]);
+		else sizes.push_back(std::stoul(argv[i]));
+	}
+	if (sizes.empty()) sizes = { 3000 };
+
+	const NationId movers[] = { NoNation, 1, 2, 3 };
+	printf("%8s %8s %8s %12s %12s %9s\n", "provs", "rounds", "fields", "Repair ms", "Flood ms", "mismatch");
+	for (size_t count : sizes)
+	{
+		std::mt19937 mt(seed);
+		ProvinceStore prov;
+		ProvinceGraph graph;
+		MakeMap(count, mt, prov, graph);
+		const auto& ids = prov.ids();
+		const size_t n = graph.capacity();
+
+		// Start with every province tolled and ruled by one of four nations.
+		for (ProvinceId p : ids) graph.SetToll(p, (float)(mt() % 25), 1 + mt() % 4);
+
+		PathFinder finder(prov, graph);
+		std::vector<Field> fields;
+		for (NationId mover : movers)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				Field F;
+				F.mover = mover;
+				F.goals.push_back(ids[mt() % ids.size()]);
+				fields.push_back(std::move(F));
+			}
+			Field F;
+			F.mover = mover;
+			for (int k = 0; k < 20; ++k) F.goals.push_back(ids[mt() % ids.size()]);
+			std::sort(F.goals.begin(), F.goals.end());
+			fields.push_back(std::move(F));
+		}
+		for (auto& F : fields)
+		{
+			F.dist.resize(n);
+			F.next.resize(n);
+			finder.Flood(F.goals.data(), F.goals.size(), F.mover, F.dist.data(), F.next.data());
+			F.epoch = graph.epoch;
+		}
+
+		std::vector<ProvinceId> changed;
+		std::vector<float> dist(n);
+		std::vector<std::uint32_t> next(n);
+		double repair = 0, flood = 0;
+		size_t mismatch = 0;
+		for (size_t r = 0; r < rounds; ++r)
+		{
+			// A few sieges: tolls up or down, exemptions handed to another nation.
+			for (size_t k = 1 + mt() % 20; k > 0; --k)
+			{
+				const ProvinceId p = ids[mt() % ids.size()];
+				if (mt() % 2) graph.SetToll(p, (float)(mt() % 25), graph.exempt[p]);
+				else graph.SetToll(p, graph.toll[p], 1 + mt() % 4);
+			}
+
+			for (auto& F : fields)
+			{
+				auto begin = Clock::now();
+				if (graph.ChangedSince(F.epoch, changed)) finder.Repair(changed.data(), changed.size(), F.mover, F.dist.data(), F.next.data());
+				else finder.Flood(F.goals.data(), F.goals.size(), F.mover, F.dist.data(), F.next.data());
+				F.epoch = graph.epoch;
+				repair += Seconds(begin);
+
+				begin = Clock::now();
+				finder.Flood(F.goals.data(), F.goals.size(), F.mover, dist.data(), next.data());
+				flood += Seconds(begin);
+				mismatch += Compare(graph, F, dist);
+			}
+		}
+
+		printf("%8zu %8zu %8zu %12.1f %12.1f %9zu\n", prov.size(), rounds, fields.size(), repair * 1e3, flood * 1e3, mismatch);
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+using ProvinceId = std::uint64_t;
+using LeaderId = std::uint64_t;
+using NationId = std::uint64_t;
+using Color32 = std::uint32_t;
+
+const ProvinceId maxProvince = 256;
+// Stands for no nation at all, e.g. a rival not yet picked.
+const NationId NoNation = ~NationId(0);
+
+// Plain vector types so the simulation does not depend on DirectXMath.
+struct Float3
+{
+	float x = 0.f;
+	float y = 0.f;
+	float z = 0.f;
+
+	Float3() = default;
+	Float3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+};
+
+struct Float4
+{
+	float x = 0.f;
+	float y = 0.f;
+	float z = 0.f;
+	float w = 0.f;
+
+	Float4() = default;
+	Float4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+};
+
+template<typename T>
+inline Color32 rgb2dex(const T& r, const T& g, const T& b)
+{
+	return ((r * 256) + g) * 256 + b;
+}
+
+inline void dex2rgb(float& r, float& g, float& b, const Color32& dex)
+{
+	r = ((dex & 16711680) / 65536) / 255.f;
+	g = ((dex & 65208) / 256) / 255.f;
+	b = (dex & 255) / 255.f;
+}
+inline void dex2rgb(unsigned char& r, unsigned char& g, unsigned char& b, const Color32& dex)
+{
+	r = static_cast<unsigned char>((dex & 16711680) / 65536);
+	g = static_cast<unsigned char>((dex & 65208) / 256);
+	b = static_cast<unsigned char>((dex & 255));
+}
+inline void dex2rgb(unsigned int& r, unsigned int& g, unsigned int& b, const Color32& dex)
+{
+	r = (dex & 16711680) / 65536;
+	g = (dex & 65208) / 256;
+	b = (dex & 255);
+}
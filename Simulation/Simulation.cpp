@@ -0,0 +1,1369 @@
+﻿#include "Simulation.h"
+
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+Simulation::Simulation() : Simulation(std::random_device()())
+{
+}
+
+Simulation::Simulation(std::uint32_t seed) : data(std::make_shared<Data>(seed)), mSeed(seed)
+{
+}
+
+void Simulation::LoadNations()
+{
+	NationId nation_count = 0;
+	{
+		std::unique_ptr<Nation> 신라 = std::make_unique<Nation>();
+		신라->MainColor = Float4(0.5f, 0.5f, 0.1f, 0.75f);
+		신라->MainName = L"신라";
+		신라->abb_attr = 2;
+		data->nations[++nation_count] = std::move(신라);
+
+		std::unique_ptr<Nation> 백제 = std::make_unique<Nation>();
+		백제->MainColor = Float4(0.1f, 0.5f, 0.45f, 0.75f);
+		백제->MainName = L"백제";
+		data->nations[++nation_count] = std::move(백제);
+		//mUser.nationPick = nation_count;
+
+		std::unique_ptr<Nation> 고구려 = std::make_unique<Nation>();
+		고구려->MainColor = Float4(0.4f, 0.0f, 0.0f, 0.75f);
+		고구려->MainName = L"고구려";
+		고구려->abb_attr = 3;
+		data->nations[++nation_count] = std::move(고구려);
+
+		std::unique_ptr<Nation> 당나라 = std::make_unique<Nation>();
+		당나라->MainColor = Float4(0.8f, 0.5f, 0.0f, 0.75f);
+		당나라->MainName = L"당나라";
+		data->nations[++nation_count] = std::move(당나라);
+
+		std::unique_ptr<Nation> 말갈 = std::make_unique<Nation>();
+		말갈->MainColor = Float4(0.25f, 0.0f, 0.0f, 0.75f);
+		말갈->MainName = L"말갈";
+		말갈->abb_man = 1.2f;
+		말갈->abb_attr = 6;
+		data->nations[++nation_count] = std::move(말갈);
+
+		std::unique_ptr<Nation> 왜 = std::make_unique<Nation>();
+		왜->MainColor = Float4(1.0f, 0.25f, 0.25f, 0.75f);
+		왜->MainName = L"왜";
+		왜->abb_man = 1.5f;
+		왜->abb_attr = 12;
+		data->nations[++nation_count] = std::move(왜);
+
+		std::unique_ptr<Nation> 원나라 = std::make_unique<Nation>();
+		원나라->MainColor = Float4(0.3f, 0.5f, 0.8f, 0.75f);
+		원나라->MainName = L"원나라";
+		원나라->abb_man = 0.2f;
+		원나라->abb_army_move = 5.f;
+		원나라->abb_army_sieze = 4.f;
+		data->nations[++nation_count] = std::move(원나라);
+
+
+		std::unique_ptr<Nation> 조선 = std::make_unique<Nation>();
+		조선->MainColor = Float4(0.125f, 0.25f, 0.5f, 0.75f);
+		조선->MainName = L"조선";
+		data->nations[++nation_count] = std::move(조선);
+
+		std::unique_ptr<Nation> 고려 = std::make_unique<Nation>();
+		고려->MainColor = Float4(1.f, 0.f, 0.f, 0.75f);
+		고려->MainName = L"고려";
+		고려->abb_man = 1.25f;
+		data->nations[++nation_count] = std::move(고려);
+
+		std::unique_ptr<Nation> 가야 = std::make_unique<Nation>();
+		가야->MainColor = Float4(0.25f, 0.5f, 0.0625f, 0.75f);
+		가야->MainName = L"가야";
+		가야->abb_man = 1.5f;
+		가야->abb_attr = 8;
+		data->nations[++nation_count] = std::move(가야);
+
+		std::unique_ptr<Nation> 한국 = std::make_unique<Nation>();
+		한국->MainColor = Float4(1.f, 1.f, 1.f, 0.75f);
+		한국->MainName = L"한국";
+		한국->abb_attr = 0.75f;
+		한국->abb_man = 10;
+		data->nations[++nation_count] = std::move(한국);
+
+		std::unique_ptr<Nation> 발해 = std::make_unique<Nation>();
+		발해->MainColor = Float4(0.75f, 0.5f, 1.f, 0.75f);
+		발해->MainName = L"발해";
+		발해->abb_attr = 2;
+		data->nations[++nation_count] = std::move(발해);
+
+		std::unique_ptr<Nation> 낙랑 = std::make_unique<Nation>();
+		낙랑->MainColor = Float4(1.f, 0.6f, 0.0625f, 0.75f);
+		낙랑->MainName = L"낙랑";
+		data->nations[++nation_count] = std::move(낙랑);
+
+		std::unique_ptr<Nation> 탐라 = std::make_unique<Nation>();
+		탐라->MainColor = Float4(0.9f, 0.3f, 0.9f, 0.75f);
+		탐라->MainName = L"탐라";
+		data->nations[++nation_count] = std::move(탐라);
+
+		std::unique_ptr<Nation> 거란 = std::make_unique<Nation>();
+		거란->MainColor = Float4(0.5f, 0.0f, 0.3f, 0.75f);
+		거란->MainName = L"거란";
+		data->nations[++nation_count] = std::move(거란);
+
+
+		std::unique_ptr<Nation> 두막루 = std::make_unique<Nation>();
+		두막루->MainColor = Float4(0.3f, 0.4f, 0.7f, 0.75f);
+		두막루->MainName = L"두막루";
+		data->nations[++nation_count] = std::move(두막루);
+
+
+		std::unique_ptr<Nation> 동부여 = std::make_unique<Nation>();
+		동부여->MainColor = Float4(0.6f, 0.1f, 0.6f, 0.75f);
+		동부여->MainName = L"동부여";
+		data->nations[++nation_count] = std::move(동부여);
+
+
+		std::unique_ptr<Nation> 부여 = std::make_unique<Nation>();
+		부여->MainColor = Float4(0.7f, 0.2f, 0.7f, 0.75f);
+		부여->MainName = L"부여";
+		data->nations[++nation_count] = std::move(부여);
+			   
+		std::unique_ptr<Nation> 예 = std::make_unique<Nation>();
+		예->MainColor = Float4(0.4f, 0.1f, 0.1f, 0.75f);
+		예->MainName = L"예";
+		data->nations[++nation_count] = std::move(예);
+
+		std::unique_ptr<Nation> 동예 = std::make_unique<Nation>();
+		동예->MainColor = Float4(0.1f, 0.3f, 0.5f, 0.75f);
+		동예->MainName = L"동예";
+		data->nations[++nation_count] = std::move(동예);
+
+
+		std::unique_ptr<Nation> 옥저 = std::make_unique<Nation>();
+		옥저->MainColor = Float4(0.8f, 0.1f, 0.1f, 0.75f);
+		옥저->MainName = L"옥저";
+		data->nations[++nation_count] = std::move(옥저);
+
+		std::unique_ptr<Nation> 태봉 = std::make_unique<Nation>();
+		태봉->MainColor = Float4(0.8f, 0.8f, 0.3f, 0.75f);
+		태봉->MainName = L"태봉";
+		data->nations[++nation_count] = std::move(태봉);
+
+		std::unique_ptr<Nation> 여진 = std::make_unique<Nation>();
+		여진->MainColor = Float4(0.8f, 0.8f, 0.6f, 0.75f);
+		여진->MainName = L"여진";
+		data->nations[++nation_count] = std::move(여진);
+
+
+		std::unique_ptr<Nation> 십제 = std::make_unique<Nation>();
+		십제->MainColor = Float4(0.6f, 0.8f, 0.1f, 0.75f);
+		십제->MainName = L"십제";
+		data->nations[++nation_count] = std::move(십제);
+
+		std::unique_ptr<Nation> 마한 = std::make_unique<Nation>();
+		마한->MainColor = Float4(0.1f, 0.2f, 0.9f, 0.75f);
+		마한->MainName = L"마한";
+		data->nations[++nation_count] = std::move(마한);
+
+
+		std::unique_ptr<Nation> 진한 = std::make_unique<Nation>();
+		진한->MainColor = Float4(1.0f, 0.5f, 0.5f, 0.75f);
+		진한->MainName = L"진한";
+		data->nations[++nation_count] = std::move(진한);
+
+		std::unique_ptr<Nation> 변한 = std::make_unique<Nation>();
+		변한->MainColor = Float4(0.2f, 0.2f, 0.2f, 0.75f);
+		변한->MainName = L"변한";
+		data->nations[++nation_count] = std::move(변한);
+		
+		std::unique_ptr<Nation> 홍건적 = std::make_unique<Nation>();
+		홍건적->MainColor = Float4(0.5f, 0.0f, 0.0f, 0.75f);
+		홍건적->MainName = L"홍건적";
+		data->nations[++nation_count] = std::move(홍건적);
+	}
+	data->RecountNations();
+}
+
+void Simulation::LoadMap(const std::wstring& prov_list, const std::vector<unsigned char>& buf, const std::vector<unsigned char>& prov_buf)
+{
+	std::map<Color32, std::pair<ProvinceId, std::wstring>> prov_key;
+	std::vector<std::pair<ProvinceId, ProvinceId>> edges;
+
+	// FNV-1a over every input; map.bmp is included because edge costs depend on height.
+	mMapKey = 1469598103934665603ull;
+	auto mix = [this](std::uint32_t v) { mMapKey = (mMapKey ^ v) * 1099511628211ull; };
+	for (wchar_t ch : prov_list) mix((std::uint32_t)ch);
+	for (unsigned char ch : buf) mix(ch);
+	for (unsigned char ch : prov_buf) mix(ch);
+	auto& Prov = data->province;
+
+	{
+		std::wstring name, index, r, g, b;
+		size_t cursor = 0;
+		while (cursor < prov_list.size())
+		{
+			size_t next = prov_list.find(L'\n', cursor);
+			if (next == std::wstring::npos) next = prov_list.size();
+			std::wstring line = prov_list.substr(cursor, next - cursor);
+			cursor = next + 1;
+
+			for (size_t i = 0; i < line.size(); ++i)
+			{
+				if (line.at(i) == ' ' || line.at(i) == '\r')
+				{
+					line.erase(i--, 1);
+					continue;
+				}
+			}
+			if (line.empty()) continue;
+
+			name = line.substr(0, line.find('/'));
+			line.erase(0, line.find('/') + 1);
+			index = line.substr(0, line.find('='));
+			line.erase(0, line.find('=') + 1);
+			r = line.substr(0, line.find(','));
+			line.erase(0, line.find(',') + 1);
+			g = line.substr(0, line.find(','));
+			line.erase(0, line.find(',') + 1);
+			b = line;
+
+			prov_key.insert(std::make_pair(rgb2dex(std::stoi(r), std::stoi(g), std::stoi(b)), std::make_pair(std::stoi(index), name)));
+		}
+	}
+
+	//B-G-R
+
+	size_t w = (((((int)buf[21] * 256) + buf[20]) * 256) + buf[19]) * 256 + buf[18];
+	size_t h = (((((int)buf[25] * 256) + buf[24]) * 256) + buf[23]) * 256 + buf[22];
+
+	data->map_w = w;
+	data->map_h = h;
+	data->province_pixel.assign(w * h, 0);
+
+	log.push_back("Map Size(w, h) = (" + std::to_string(w) + ", " + std::to_string(h) + ")");
+
+	std::vector<float> height(w * h);
+	std::unordered_map<Color32, std::pair<Color32, size_t>> unregisted_color;
+
+	size_t addr, naddr;
+	Color32 dex, ndex;
+	size_t nx, ny;
+	int W[4][2] = { {1 , 0}, {0, -1}, {-1, 0}, {0, 1} };
+
+	for (size_t y = h - 1;; --y) {
+		for (size_t x = 0; x < w; ++x) {
+			addr = 54 + (x + (y * w)) * 3;
+
+			height[x + y * w] = (float)(buf[addr + 0] + buf[addr + 1] + buf[addr + 2]) / 127 - 1.5f;
+			Float3 pos((x - (w - 1) / 2.f), height[x + y * w], (y - (h - 1) / 2.f));
+
+			dex = rgb2dex(prov_buf.at(addr + 2), prov_buf.at(addr + 1), prov_buf.at(addr));
+
+			//Registed Province Color
+			if (auto search = prov_key.find(dex); search != prov_key.end())
+			{
+				for (int i = 0; i < 4; i++)
+				{
+					nx = x + W[i][0];
+					ny = y + W[i][0];
+					naddr = 54 + (nx + (ny * w)) * 3;
+					if (nx < w && ny < h)
+					{
+						ndex = rgb2dex(prov_buf.at(naddr + 2), prov_buf.at(naddr + 1), prov_buf.at(naddr));
+						if (dex != ndex)
+						{
+							if (auto nsearch = prov_key.find(ndex); nsearch != prov_key.end())
+							{
+								edges.push_back(std::make_pair(search->second.first, nsearch->second.first));
+							}
+						}
+					}
+				}
+				const ProvinceId id = search->second.first;
+				data->province_pixel[x + y * w] = id;
+				if (!Prov.contains(id))
+				{
+					Prov.Add(id, search->second.second, dex, pos);
+					Prov.man[id] = 1000 + data->Rand() % 1600;
+					Prov.maxman[id] = 4000 + data->Rand() % 6400;
+				}
+				else
+				{
+					Prov.pixel[id].x += pos.x;
+					Prov.pixel[id].y += pos.y;
+					Prov.pixel[id].z += pos.z;
+					++Prov.p_num[id];
+				}
+			}
+			else if (dex * (dex - 8421504) != 0)
+			{
+				if (auto O = unregisted_color.find(dex); O == unregisted_color.end())
+				{
+					float R0, G0, B0, R1, G1, B1;
+					float syc = FLT_MAX;
+					Color32 ind = 0;
+					dex2rgb(R0, G0, B0, dex);
+
+					for (const auto& P : prov_key)
+					{
+						dex2rgb(R1, G1, B1, P.first);
+						if (float get = powf(R0 - R1, 2.f) + powf(G0 - G1, 2.f) + powf(B0 - B1, 2.f); get < syc)
+						{
+							syc = get;
+							ind = P.first;
+						}
+					}
+					unregisted_color.insert(std::make_pair(dex, std::make_pair(ind, 1)));
+				}
+				else
+				{
+					O->second.second++;
+				}
+			}
+		}
+		if (y == 0)
+		{
+			break;
+		}
+	}
+
+	for (const auto& O : unregisted_color)
+	{
+		unsigned int r, g, b, r1, g1, b1;
+		dex2rgb(r, g, b, O.first);
+		dex2rgb(r1, g1, b1, O.second.first);
+		log.push_back("Unregisted Color (" + std::to_string(r) + ", " + std::to_string(g) + ", " + std::to_string(b) + ") x " + std::to_string(O.second.second) + " : It looks like (" + std::to_string(r1) + ", " + std::to_string(g1) + ", " + std::to_string(b1) + ")");
+	}
+
+	for (ProvinceId O : Prov.ids())
+	{
+		int x = (int)(1.f * Prov.pixel[O].x / Prov.p_num[O] + (w - 1.f) / 2.f);
+		int y = (int)(1.f * Prov.pixel[O].z / Prov.p_num[O] + (h - 1.f) / 2.f);
+
+		if (x >= 0 && (size_t)x < w && y >= 0 && (size_t)y < h)
+		{
+			Prov.on3Dpos[O].x = 2.f * Prov.pixel[O].x / Prov.p_num[O];
+			Prov.on3Dpos[O].y = 2.f * height.at(x + w * y) - 2.f;
+			Prov.on3Dpos[O].z = 2.f * Prov.pixel[O].z / Prov.p_num[O];
+		}
+	}
+
+	data->province_connect.Build(Prov.capacity(), std::move(edges));
+	data->province_connect.Reweight([&Prov](ProvinceId O, ProvinceId P)
+	{
+		float width = sqrtf(powf(Prov.on3Dpos[O].x - Prov.on3Dpos[P].x, 2) + powf(Prov.on3Dpos[O].z - Prov.on3Dpos[P].z, 2));
+		float height = std::max(-Prov.on3Dpos[O].y + Prov.on3Dpos[P].y, 0.f);
+		return width + height;
+	});
+	for (ProvinceId O : Prov.ids()) data->province_connect.SetToll(O, data->RulerToll(O), Prov.ruler[O]);
+	data->regions.Build();
+	data->awake = Prov.ids();
+	data->RecountNations();
+}
+
+bool Simulation::PrepareDistances(const std::string& cache_path)
+{
+	if (data->province_connect.capacity() > DistanceTable::MaxProvinces)
+	{
+		log.push_back("Path table skipped: " + std::to_string(data->province.size()) + " provinces, using " + std::to_string(data->regions.region_count()) + " regions");
+		return false;
+	}
+	if (data->distances.Load(cache_path, mMapKey, data->province_connect))
+	{
+		log.push_back("Path table loaded from " + cache_path);
+		return true;
+	}
+
+	data->distances.Build(data->province, data->province_connect, mMapKey);
+	if (data->distances.Save(cache_path)) log.push_back("Path table written to " + cache_path);
+	else log.push_back("Path table could not be written to " + cache_path);
+	return true;
+}
+
+bool Simulation::PrepareHierarchy(const std::string& cache_path)
+{
+	if (data->hierarchy.Load(cache_path, mMapKey, data->province_connect))
+	{
+		log.push_back("Path hierarchy loaded from " + cache_path);
+		return true;
+	}
+
+	data->hierarchy.Build(data->province_connect, mMapKey);
+	if (data->hierarchy.Save(cache_path)) log.push_back("Path hierarchy written to " + cache_path);
+	else log.push_back("Path hierarchy could not be written to " + cache_path);
+	return false;
+}
+
+void Simulation::LoadScenario(const std::wstring& wstr)
+{
+	size_t cursor = 0, next;
+	while (1)
+	{
+		next = wstr.find(L';', cursor);
+		if (next == std::wstring::npos)
+		{
+			Query(wstr.substr(cursor));
+			break;
+		}
+		Query(wstr.substr(cursor, next - cursor));
+		cursor = next + 1;
+	}
+}
+
+std::wstring Simulation::SaveScenario() const
+{
+	std::wstring file;
+
+	file += L"SAVE\tSTART;\n";
+
+	for (ProvinceId O : data->province.ids())
+	{
+		file += L"PROVINCE\t-id " + std::to_wstring(O);
+
+		if (auto find = data->nations.find(data->province.ruler[O]); find != data->nations.end())
+		{
+			file += L" -ruler " + find->second->MainName;
+		}
+		if (auto find = data->nations.find(data->province.owner[O]); find != data->nations.end())
+		{
+			file += L" -owner " + find->second->MainName;
+		}
+
+		file += L";\n";
+	}
+
+	file += L"SAVE\tEND;\n";
+	return file;
+}
+
+void Simulation::Query(const std::wstring& query)
+{
+	if (mQuery.enable)
+	{
+		if (query == L"SAVE\tEND")
+		{
+			mQuery.enable = false;
+			return;
+		}
+
+
+		mQuery.word.clear();
+
+		for (mQuery.pos = 0; mQuery.pos < query.size(); ++mQuery.pos)
+		{
+			auto ch = query.at(mQuery.pos);
+
+			if (mQuery.isLineComment)
+			{
+				if (ch == L'\n' || ch == L'\r')
+					mQuery.isLineComment = false;
+			}
+			else if (mQuery.isComment)
+			{
+				if (ch == L'*' && mQuery.pos + 1 < query.size())
+					if (query.at(mQuery.pos + 1) == L'*')
+					{
+						mQuery.isComment = false;
+						++mQuery.pos;
+					}
+			}
+			else if (ch == L'"')
+				mQuery.isString = !mQuery.isString;
+			else if (mQuery.isString)
+				mQuery.word.rbegin()->push_back(ch);
+			else if (ch == L'\t' || ch == L' ' || ch == L'\n' || ch == L'\r')
+			{
+				mQuery.word.push_back(L"");
+			}
+			else if (ch == L'/' && mQuery.pos + 1 < query.size())
+			{
+				if (query.at(mQuery.pos + 1) == L'/')
+				{
+					mQuery.isLineComment = true;
+					++mQuery.pos;
+				}
+				else if (query.at(mQuery.pos + 1) == L'*')
+				{
+					mQuery.isComment = true;
+					++mQuery.pos;
+				}
+				else
+					mQuery.word.rbegin()->push_back(ch);
+			}
+			else
+			{
+				if (mQuery.word.empty()) mQuery.word.push_back(L"");
+				mQuery.word.rbegin()->push_back(ch);
+			}
+		}
+
+		while (mQuery.word.size() > 0 && (*mQuery.word.cbegin() == L""))
+		{
+			mQuery.word.pop_front();
+		}
+		if (mQuery.word.size() > 0)
+		{
+			mQuery.index = L"";
+			if (*mQuery.word.cbegin() == L"PROVINCE")
+			{
+				mQuery.tag_prov = 0;
+
+				for (auto O : mQuery.word)
+				{
+					if (O.empty()) continue;
+					if (O.at(0) == L'-')
+						mQuery.index = O;
+					else
+					{
+						if (mQuery.index == L"-id")
+						{
+							mQuery.tag_prov = std::stoll(O);
+							if (!data->province.contains(mQuery.tag_prov)) mQuery.tag_prov = 0;
+						}
+						else if (mQuery.index == L"-ruler")
+						{
+							if (mQuery.tag_prov != 0)
+							{
+								for (const auto& N : data->nations)
+								{
+									if (N.second->MainName == O)
+									{
+										data->SetRuler(mQuery.tag_prov, N.first);
+										break;
+									}
+								}
+							}
+						}
+						else if (mQuery.index == L"-owner")
+						{
+							if (mQuery.tag_prov != 0)
+							{
+								for (const auto& N : data->nations)
+								{
+									if (N.second->MainName == O)
+									{
+										data->SetOwner(mQuery.tag_prov, N.first);
+										break;
+									}
+								}
+							}
+						}
+						else if (mQuery.index == L"-develop")
+						{
+							if (mQuery.tag_prov != 0)
+							{
+								data->Wake(mQuery.tag_prov);
+								data->province.maxman[mQuery.tag_prov] = (std::int64_t)((4 + powf(std::stoi(O) / 2.f, 2)) * 1000);
+								data->province.man[mQuery.tag_prov] = data->province.maxman[mQuery.tag_prov] / 10;
+							}
+						}
+
+					}
+				}
+			}
+
+		}
+	}
+	else if (query == L"SAVE\tSTART")
+	{
+		mQuery.enable = true;
+	}
+}
+
+std::unordered_map<std::wstring, std::wstring> Simulation::Act(const std::wstring& func_name, std::initializer_list<std::wstring> args, bool only_test)
+{
+	std::unordered_map<std::wstring, std::wstring> _Return;
+	std::unordered_map<std::wstring, std::wstring> arg;
+	std::wstring head;
+	for (auto P = args.begin();;)
+	{
+		if (P == args.end()) break;
+		head = *(P++);
+		if (P == args.end()) break;
+		arg[head] = *(P++);
+	}
+
+	if (func_name == L"Draft")
+	{
+		DraftRequest R;
+		R.location = std::stoull(arg[L"location"]);
+		if (arg.find(L"size") != arg.end()) R.size = std::stoll(arg[L"size"]);
+		if (arg.find(L"owner") != arg.end()) R.owner = std::stoull(arg[L"owner"]);
+		if (arg.find(L"force") != arg.end()) R.force = true;
+		if (arg.find(L"abb_move") != arg.end()) R.abb_move = std::stof(arg[L"abb_move"]);
+		if (arg.find(L"abb_sieze") != arg.end()) R.abb_sieze = std::stof(arg[L"abb_sieze"]);
+		if (arg.find(L"abb_disp") != arg.end()) R.abb_disp = std::stof(arg[L"abb_disp"]);
+
+		if (only_test)
+		{
+			if (CanDraft(R) == DraftResult::Ok) _Return.insert(std::make_pair(L"SUCCESS", L""));
+		}
+		else if (LeaderId id; Draft(R, &id) == DraftResult::Ok)
+		{
+			_Return.insert(std::make_pair(L"leaderid", std::to_wstring(id)));
+		}
+	}
+	return _Return;
+}
+
+DraftResult Simulation::CanDraft(const DraftRequest& request) const
+{
+	const auto& Prov = data->province;
+	if (!Prov.contains(request.location)) return DraftResult::NoProvince;
+	if (!request.force && Prov.Man(request.location, data->tick) < request.size) return DraftResult::NotEnoughMen;
+	return DraftResult::Ok;
+}
+
+DraftResult Simulation::Draft(const DraftRequest& request, LeaderId* drafted)
+{
+	if (const DraftResult R = CanDraft(request); R != DraftResult::Ok) return R;
+
+	auto& Prov = data->province;
+	const ProvinceId id = request.location;
+	const auto N = data->nations.find(Prov.ruler[id]);
+
+	data->Settle(id);
+	if (!request.force) Prov.man[id] -= request.size;
+
+	auto L = data->NewLeader(id, request.owner ? *request.owner : N != data->nations.end() ? N->first : 0, request.size);
+	if (N != data->nations.end())
+	{
+		L.abb_move = N->second->abb_army_move;
+		L.abb_sieze = N->second->abb_army_sieze;
+		L.abb_disp = N->second->abb_disp;
+	}
+	if (request.abb_move) L.abb_move = *request.abb_move;
+	if (request.abb_sieze) L.abb_sieze = *request.abb_sieze;
+	if (request.abb_disp) L.abb_disp = *request.abb_disp;
+
+	const LeaderId l = data->AddLeader(std::move(L));
+	++data->leader_progress;
+	if (drafted) *drafted = l;
+	return DraftResult::Ok;
+}
+
+std::vector<ProvincePath> Simulation::MoveLeaders(const std::vector<LeaderId>& ids, ProvinceId target)
+{
+	const auto& conn = data->province_connect;
+	std::vector<ProvincePath> routes(ids.size());
+
+	// A lone leader needs just one point query, which the path cache remembers across
+	// repeated clicks; a group shares its nation's flow field towards target.
+	if (ids.size() == 1)
+	{
+		if (auto O = data->leaders.find(ids[0]); O != data->leaders.end())
+		{
+			auto& L = O->second;
+			const ProvincePath path = L.location == target ? ProvincePath() : data->Route(L.location, target, L.owner);
+			if (path.length != FLT_MAX)
+			{
+				L.cmd.clear();
+				data->SetLeaderGoal(L, 0);
+				ProvinceId lastLoc = L.location;
+				for (ProvinceId P : path.path)
+				{
+					L.cmd.push_back(Command(CommandType::Move, P, 0, conn.at(lastLoc, P)));
+					lastLoc = P;
+				}
+				data->StartOrder(ids[0], L);
+				routes[0].length = path.length;
+			}
+			for (const auto& C : L.cmd)
+			{
+				if (C.type == CommandType::Move) routes[0].path.push_back(C.target_prov);
+			}
+		}
+		return routes;
+	}
+
+	// One field per nation in the group, held until every leader has read it.
+	std::vector<NationId> owners;
+	for (LeaderId id : ids)
+	{
+		auto O = data->leaders.find(id);
+		if (O == data->leaders.end() || std::find(owners.begin(), owners.end(), O->second.owner) != owners.end()) continue;
+		owners.push_back(O->second.owner);
+		data->flows.Acquire(target, O->second.owner);
+	}
+
+	for (size_t i = 0; i < ids.size(); ++i)
+	{
+		auto O = data->leaders.find(ids[i]);
+		if (O == data->leaders.end()) continue;
+		auto& L = O->second;
+		const FlowField& F = data->flows.Get(target, L.owner);
+
+		if (L.location == target)
+		{
+			L.cmd.clear();
+			data->SetLeaderGoal(L, 0);
+			data->StartOrder(ids[i], L);
+		}
+		else if (F.Reachable(L.location))
+		{
+			L.cmd.clear();
+			data->SetLeaderGoal(L, target);
+			for (ProvinceId lastLoc = L.location; lastLoc != target;)
+			{
+				const ProvinceId P = F.Next(lastLoc);
+				L.cmd.push_back(Command(CommandType::Move, P, 0, conn.at(lastLoc, P)));
+				lastLoc = P;
+			}
+			data->StartOrder(ids[i], L);
+			routes[i].length = F.dist[L.location];
+		}
+
+		for (const auto& C : L.cmd)
+		{
+			if (C.type == CommandType::Move) routes[i].path.push_back(C.target_prov);
+		}
+	}
+	for (NationId owner : owners) data->flows.Release(target, owner);
+	return routes;
+}
+
+void Simulation::Step(std::uint64_t n)
+{
+	flag_update_leaders = false;
+	for (std::uint64_t i = 0; i < n; ++i)
+	{
+		ApplyCommands();
+		++data->tick;
+		Tick();
+	}
+	Publish();
+}
+
+void Simulation::ApplyCommands()
+{
+	for (SimCommand C; mCommands.Pop(C);)
+	{
+		if (auto* R = std::get_if<DraftRequest>(&C))
+		{
+			Draft(*R);
+		}
+		else if (auto* M = std::get_if<MoveCommand>(&C))
+		{
+			MoveLeaders(M->leaders, M->target);
+			for (LeaderId id : M->leaders)
+			{
+				if (auto O = data->leaders.find(id); O != data->leaders.end() && O->second.selected) flag_update_leaders = true;
+			}
+		}
+		else if (auto* S = std::get_if<SelectCommand>(&C))
+		{
+			for (auto& O : data->leaders) O.second.selected = false;
+			for (LeaderId id : S->leaders)
+			{
+				if (auto O = data->leaders.find(id); O != data->leaders.end()) O->second.selected = true;
+			}
+			flag_update_leaders = true;
+		}
+		else if (auto* A = std::get_if<AiCommand>(&C))
+		{
+			if (auto N = data->nations.find(A->nation); N != data->nations.end()) N->second->Ai = A->ai;
+		}
+		else if (auto* L = std::get_if<LoadCommand>(&C))
+		{
+			LoadScenario(L->scenario);
+		}
+		else if (auto* V = std::get_if<SaveCommand>(&C))
+		{
+			if (V->done) V->done(SaveScenario());
+		}
+	}
+}
+
+void Simulation::Publish()
+{
+	const auto& Prov = data->province;
+	const size_t n = Prov.capacity();
+	RenderSnapshot& S = mSnapshots.Back();
+	S.tick = data->tick;
+
+	auto color = [this](NationId id)
+	{
+		auto N = data->nations.find(id);
+		return N != data->nations.end() ? N->second->MainColor : Float4(0.f, 0.f, 0.f, 0.f);
+	};
+	S.owner.assign(Prov.owner.begin(), Prov.owner.end());
+	S.ruler.assign(Prov.ruler.begin(), Prov.ruler.end());
+	S.maxman.assign(Prov.maxman.begin(), Prov.maxman.end());
+	S.owner_color.resize(n);
+	S.ruler_color.resize(n);
+	S.man.resize(n);
+	S.hp.resize(n);
+	S.draftable.assign(n, 0);
+	for (ProvinceId O = 0; O < n; ++O)
+	{
+		S.owner_color[O] = color(Prov.owner[O]);
+		S.ruler_color[O] = color(Prov.ruler[O]);
+		S.man[O] = Prov.Man(O, data->tick);
+		S.hp[O] = Prov.Hp(O, data->tick);
+	}
+	for (ProvinceId O : Prov.ids()) S.draftable[O] = CanDraft(DraftRequest::At(O)) == DraftResult::Ok;
+
+	S.leaders.clear();
+	S.route.clear();
+	S.by_id.clear();
+	S.at.assign(n + 1, 0);
+	for (ProvinceId O = 0; O < n; ++O)
+	{
+		S.at[O] = (std::uint32_t)S.leaders.size();
+		for (LeaderId l : data->LeadersAt(O))
+		{
+			const Leader& L = data->leaders.at(l);
+			RenderSnapshot::Leader V;
+			V.id = l;
+			V.owner = L.owner;
+			V.location = L.location;
+			V.size = L.size;
+			V.orders = L.cmd.size();
+			if (!L.cmd.empty())
+			{
+				V.order = L.cmd.front().type;
+				V.target = L.cmd.front().target_prov;
+				V.progress = L.Progress(data->tick);
+				V.need = L.cmd.front().need;
+			}
+			V.route_begin = (std::uint32_t)S.route.size();
+			for (const auto& C : L.cmd)
+			{
+				V.total_need += C.need;
+				if (C.type == CommandType::Move) S.route.push_back(C.target_prov);
+			}
+			V.route_end = (std::uint32_t)S.route.size();
+			S.by_id.emplace_back(l, (std::uint32_t)S.leaders.size());
+			S.leaders.push_back(V);
+		}
+	}
+	S.at[n] = (std::uint32_t)S.leaders.size();
+	std::sort(S.by_id.begin(), S.by_id.end());
+
+	mSnapshots.Publish();
+}
+
+void Simulation::Tick()
+{
+	auto& Prov = data->province;
+
+	// Quiet provinces regenerate in closed form.  The others are gathered so the two
+	// drifts and the hp step run as kernels; the draws and drafts in between stay in
+	// province order.
+	const auto& awake = data->awake;
+	const EconomyKernel& K = Economy();
+	mEconomy.Gather(Prov, awake);
+	K.drift(mEconomy.man.data(), mEconomy.maxman.data(), nullptr, awake.size());
+	for (size_t i = 0; i < awake.size(); ++i)
+	{
+		const ProvinceId O = awake[i];
+		Prov.man[O] = mEconomy.man[i];
+
+		if (Prov.owner[O] != Prov.ruler[O] && Prov.man[O] > Prov.maxman[O] / 4)
+		{
+			int roll = (int)(1.0 * data->Rand() / Data::RandMax * 30000);
+			if (Prov.man[O] + Prov.hp[O] * 2 > data->Rand() % (1 + roll) + Prov.maxman[O] / 4)
+			{
+				Draft(DraftRequest::At(O).Size(Prov.man[O]).Owner(Prov.owner[O]));
+			}
+		}
+		if (Prov.owner[O] == Prov.ruler[O])
+		{
+			auto N = data->nations.find(Prov.ruler[O]);
+			if (N != data->nations.end())
+			{
+				mEconomy.rate[i] = N->second->abb_man;
+			}
+			else if (Prov.hp[O] < Prov.p_num[O] / 5 && Prov.man[O] > 6000)
+			{
+				Draft(DraftRequest::At(O).Size(Prov.man[O]).Owner(Prov.owner[O]));
+			}
+		}
+		mEconomy.man[i] = Prov.man[O];
+
+		if (Prov.hp[O] >= Prov.p_num[O] && Prov.owner[O] != Prov.ruler[O]) data->SetOwner(O, Prov.ruler[O]);
+
+		// Nothing but the drift is left once a nation rules what it owns.
+		if (auto N = data->nations.find(Prov.ruler[O]); Prov.owner[O] == Prov.ruler[O] && N != data->nations.end())
+		{
+			Prov.quiet[O] = 1;
+			Prov.man_rate[O] = N->second->abb_man;
+			Prov.settled[O] = data->tick;
+		}
+	}
+	K.drift(mEconomy.man.data(), mEconomy.maxman.data(), mEconomy.rate.data(), awake.size());
+	K.repair(mEconomy.hp.data(), mEconomy.p_num.data(), awake.size());
+	mEconomy.Scatter(Prov, awake);
+	data->awake.erase(std::remove_if(data->awake.begin(), data->awake.end(), [&Prov](ProvinceId O) { return Prov.quiet[O]; }), data->awake.end());
+
+	for (const auto& O : data->leaders)
+	{
+		if (O.second.size <= 0)
+		{
+			data->EraseLeader(O.first, O.second);
+		}
+	}
+	data->leaders.flush();
+
+	for (auto& O : data->leaders)
+	{
+		if (O.second.owner != Prov.ruler.at(O.second.location))
+		{
+			if (const auto & N = data->nations.find(Prov.ruler.at(O.second.location)); N != data->nations.end())
+			{
+				O.second.size -= (std::int64_t)std::round(O.second.size * N->second->abb_attr / 10000.f * 2 * data->Rand() / Data::RandMax);
+			}
+			else
+			{
+				O.second.size -= (std::int64_t)std::round(O.second.size * 5 / 10000.f * 2 * data->Rand() / Data::RandMax);
+			}
+		}
+		else
+		{
+			if (const ProvinceId P = O.second.location; true)
+			{
+				data->Settle(P);
+				if (Prov.owner[P] == Prov.ruler[P])
+				{
+					if (O.second.owner == Prov.owner[P])
+					{
+						for (int i = 1; i < 100 && i * i * 9 <= Prov.man[P]; ++i)
+						{
+							O.second.size += 9 * i * i;
+							Prov.man[P] -= 9 * i * i;
+						}
+					}
+				}
+				else if (Prov.ruler[P] == O.second.owner)
+				{
+					if (Prov.hp[P] < Prov.p_num[P]) Prov.hp[P] += 1;
+				}
+			}
+		}
+		data->PlaceLeader(O.second);
+		if (O.second.cmd.size() > 0)
+		{
+			if (O.second.selected) flag_update_leaders = true;
+		}
+		else
+		{
+			std::vector<LeaderId> sameLocLeader;
+			for (LeaderId l : data->LeadersAt(O.second.location))
+			{
+				const auto& L = data->leaders.at(l);
+				if (L.owner != O.second.owner)
+				{
+					if (L.cmd.size() > 0 && L.cmd.begin()->type == CommandType::Sieze)
+					{
+						sameLocLeader.clear();
+						sameLocLeader.push_back(l);
+						break;
+					}
+					else
+					{
+						sameLocLeader.push_back(l);
+					}
+				}
+			}
+			if (sameLocLeader.size() > 0)
+			{
+				O.second.cmd.push_back(Command(CommandType::Attack, 0, sameLocLeader.at(data->Rand() % sameLocLeader.size()), 10));
+				data->StartOrder(O.first, O.second);
+			}
+			else if (Prov.ruler.at(O.second.location) != O.second.owner)
+			{
+				O.second.cmd.push_back(Command(CommandType::Sieze, O.second.location, 0, 20 / O.second.abb_sieze));
+				data->StartOrder(O.first, O.second);
+			}
+			else
+			{
+				data->Settle(O.second.location);
+				if (Prov.hp.at(O.second.location) < 1000) Prov.hp.at(O.second.location) += O.second.size / 1000;
+			}
+		}
+	}
+
+
+	// Only the leaders whose first order completes this tick; stale bookings are skipped.
+	std::vector<OrderDue> due;
+	data->orders.Advance(data->tick, due);
+	for (const auto& E : due)
+	{
+		auto O = data->leaders.find(E.leader);
+		if (O == data->leaders.end() || O->second.cmd_serial != E.serial || O->second.cmd.empty()) continue;
+		auto& L = O->second;
+		const Command B = L.cmd.front();
+		L.cmd.pop_front();
+
+		switch (B.type)
+		{
+		case CommandType::Move:
+			data->MoveLeader(E.leader, L, B.target_prov);
+			if (L.location == L.goal) data->SetLeaderGoal(L, 0);
+			break;
+		case CommandType::Sieze:
+			{
+				const ProvinceId P = L.location;
+				data->Settle(P);
+				Prov.hp[P] -= (77 + data->Rand() % 100 + L.size / 600) * 2;
+				if (Prov.hp[P] <= 0)
+				{
+					data->SetRuler(P, L.owner);
+					Prov.hp[P] = 0;
+				}
+			}
+			break;
+		case CommandType::Attack:
+			auto T = data->leaders.find(B.target_leader);
+			if (T != data->leaders.end() && T->second.location == L.location && L.size > 0 && T->second.size > 0)
+			{
+				if (T->second.owner == Prov.owner.at(L.location)) {
+					T->second.size -= L.size / 4 * 170 / 200;
+				}
+				else {
+					T->second.size -= L.size / 4;
+				}
+				data->PlaceLeader(T->second);
+
+				if (T->second.size > 0)
+				{
+					L.size -= T->second.size / 4;
+					if (T->second.cmd.size() > 0 && (T->second.cmd.begin()->type == CommandType::Sieze || T->second.cmd.begin()->type == CommandType::Move))
+					{
+						data->CancelOrder(T->first, T->second);
+					}
+				}
+			}
+			break;
+		}
+		data->StartOrder(E.leader, L);
+		if (L.selected) flag_update_leaders = true;
+	}
+
+
+	PlanNations();
+}
+
+void Simulation::PlanNations()
+{
+	if (data->nations.empty()) return;
+
+	if (!mPool || mPoolThreads != ai.threads)
+	{
+		mPool = std::make_unique<WorkerPool>(ai.threads);
+		mPoolThreads = ai.threads;
+	}
+	while (mWorkers.size() < mPool->size()) mWorkers.push_back(std::make_unique<AiWorker>(data->province, data->province_connect));
+
+	// Each nation's leaders in the order Data::leaders holds them.
+	Armies armies;
+	for (const auto& L : data->leaders) armies[L.second.owner].push_back(L.first);
+
+	std::vector<NationId> order;
+	order.reserve(data->nations.size());
+	for (const auto& N : data->nations) order.push_back(N.first);
+	std::sort(order.begin(), order.end());
+	const size_t n = order.size();
+
+	ai.BeginTick();
+	size_t first = 0;
+	bool resume = false;
+	if (ai.waiting)
+	{
+		first = std::lower_bound(order.begin(), order.end(), ai.cursor.nation) - order.begin();
+		if (first == n) first = 0;
+		resume = ai.cursor.resume && order[first] == ai.cursor.nation;
+	}
+
+	// Without a budget every nation plans against the same state at once.  Under one
+	// they go a pool's width at a time, so the clock is looked at in between.
+	const size_t width = ai.budget_us ? mPool->size() : n;
+	auto& jobs = mJobs;
+	auto& plans = mPlans;
+	if (jobs.size() < width) jobs.resize(width);
+	if (plans.size() < width) plans.resize(width);
+	for (size_t done = 0, count = 0; done < n; done += count)
+	{
+		if (done > 0 && ai.Expired())
+		{
+			ai.cursor = AiScheduler::Cursor{ order[(first + done) % n], false, 0 };
+			ai.waiting = true;
+			return;
+		}
+
+		count = std::min(width, n - done);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const bool resuming = resume && done + i == 0;
+			PrepareNation(jobs[i], order[(first + done + i) % n], armies, resuming, resuming ? ai.cursor.leader : 0);
+			if (resuming) plans[i].prioriy.swap(mPending.prioriy);
+		}
+
+		mPool->Run(count, [&](size_t i, size_t worker)
+		{
+			const auto start = AiScheduler::Clock::now();
+			PlanNation(jobs[i], *mWorkers[worker], plans[i]);
+			plans[i].us = std::chrono::duration<double, std::micro>(AiScheduler::Clock::now() - start).count();
+		});
+
+		// Applied in nation id order, so the outcome does not depend on the threads.
+		// The first plan the budget cut short is the last one applied; the cursor
+		// resumes it, and the nations after it are planned afresh when their turn
+		// comes, so nothing they decided here is applied twice.
+		for (size_t i = 0; i < count; ++i)
+		{
+			const auto start = AiScheduler::Clock::now();
+			ApplyPlan(jobs[i], plans[i]);
+			const double us = plans[i].us + std::chrono::duration<double, std::micro>(AiScheduler::Clock::now() - start).count();
+			ai.Spent(jobs[i].id, us, plans[i].finished, data->tick);
+			if (!plans[i].finished)
+			{
+				if (jobs[i].army != &mPending.army) mPending.army = *jobs[i].army;
+				mPending.prioriy.swap(plans[i].prioriy);
+				ai.cursor = AiScheduler::Cursor{ jobs[i].id, true, plans[i].next };
+				ai.waiting = true;
+				return;
+			}
+		}
+	}
+
+	// Everyone had a turn.  Under a budget the next tick starts where this one would
+	// have gone on; without one every tick starts from the lowest id.
+	ai.cursor = AiScheduler::Cursor{ order[first], false, 0 };
+	ai.waiting = ai.budget_us != 0;
+}
+
+void Simulation::PrepareNation(NationJob& J, NationId id, Armies& armies, bool resume, size_t next)
+{
+	const Nation& N = *data->nations.at(id);
+
+	J.id = id;
+	J.nation = &N;
+	J.army = resume ? &mPending.army : &armies[id];
+	J.resume = resume;
+	J.next = next;
+	J.rival = N.rival;
+	J.provinces.clear();
+	J.frontier = nullptr;
+	J.total = nullptr;
+	J.mine = nullptr;
+	if (!N.Ai || N.owned.empty() || N.ruled.empty()) return;
+
+	if (J.rival != NoNation)
+	{
+		if (auto n = data->nations.find(J.rival); n == data->nations.end() || (n->second->owned.empty() && n->second->ruled.empty())) J.rival = NoNation;
+	}
+
+	if (!resume)
+	{
+		ForEachBit(std::max(N.owned.word_count(), N.ruled.word_count()), [&](size_t i) { return N.owned.word(i) | N.ruled.word(i); }, [&J](ProvinceId P) { J.provinces.push_back(P); });
+		if (J.rival == NoNation) J.frontier = &data->frontiers.Get(id, J.provinces, data->pathfinder, data->province_connect);
+	}
+
+	// Priorities are only read by idle leaders, and a resumed plan keeps its own.
+	const auto& army = *J.army;
+	if ((!resume || mPending.prioriy.empty()) && std::any_of(army.begin() + std::min(next, army.size()), army.end(), [&](LeaderId l) { auto O = data->leaders.find(l); return O != data->leaders.end() && O->second.cmd.empty(); }))
+	{
+		J.total = &data->influence.Total();
+		J.mine = &data->influence.Friendly(id);
+	}
+}
+
+void Simulation::PlanNation(const NationJob& J, AiWorker& W, NationPlan& plan) const
+{
+	const auto& Prov = data->province;
+	const Nation& N = *J.nation;
+	const std::vector<LeaderId>& myLead = *J.army;
+	plan.rival = J.rival;
+	plan.drafts.clear();
+	plan.orders.clear();
+	plan.finished = true;
+	plan.next = J.next;
+
+	if (N.Ai && !N.owned.empty() && !N.ruled.empty())
+	{
+		const ProvinceSet& owned = N.owned;
+		const ProvinceSet& ruled = N.ruled;
+		std::vector<float>& prioriy = plan.prioriy;
+
+		// The army terms come from the influence map: strength heading for or standing
+		// near each province.  Orders already given adjust the priorities as they go,
+		// and a resumed plan picks them up where they were.
+		if (!J.total)
+		{
+			if (!J.resume) prioriy.clear();
+		}
+		else
+		{
+			const auto& total = *J.total;
+			const auto& mine = *J.mine;
+			prioriy.assign(Prov.capacity(), 0.f);
+			for (ProvinceId P : Prov.ids())
+			{
+				if (Prov.owner[P] == J.id)
+				{
+					if (Prov.ruler[P] == J.id) //내 영토의 내 소유
+					{
+						prioriy[P] = 1.f * (2000 - Prov.Hp(P, data->tick));
+					}
+					else							//내 영토의 적 소유
+					{
+						prioriy[P] = 3.f * (2000 - Prov.Hp(P, data->tick));
+					}
+				}
+				else
+				{
+					if (Prov.ruler[P] == J.id)	 //적 영토의 내 소유
+					{
+						prioriy[P] = 2.f * (2000 - Prov.Hp(P, data->tick)) * (J.rival == Prov.ruler[P] ? 2 : 1);
+					}
+					else							 //적 영토의 적 소유
+					{
+						prioriy[P] = 1.f * (2000 - Prov.Hp(P, data->tick)) * (J.rival == Prov.ruler[P] ? 2 : 1);
+					}
+				}
+
+				const float friendly = mine[P];
+				const float threat = total[P] - mine[P];
+				const bool rival_owns = J.rival == Prov.owner[P];
+				if (Prov.ruler[P] == J.id)	// 내 땅에 남 군사, 내 군사
+					prioriy[P] += 2 * threat * (rival_owns ? 2 : 1) - 2 * friendly;
+				else						// 남 땅에 내 군사, 남 군사
+					prioriy[P] -= (0.1f * friendly + threat) * (rival_owns ? 0.5f : 1.f);
+			}
+		}
+
+		// Rivalry and drafting are settled once per plan, not again when it resumes.
+		if (!J.resume)
+		{
+			if (plan.rival == NoNation)
+			{
+				float syn = -FLT_MAX;
+				const auto& frontier = *J.frontier;
+				for (auto& n : data->nations)
+				{
+					if (!n.second->owned.empty() && !n.second->ruled.empty() && n.first != J.id)
+					{
+						// Only provinces split between the two or wholly theirs can score.
+						const ProvinceSet& their_owned = n.second->owned;
+						const ProvinceSet& their_ruled = n.second->ruled;
+						const size_t words = std::max({ owned.word_count(), ruled.word_count(), their_owned.word_count(), their_ruled.word_count() });
+						float my_syn = 0;
+						ForEachBit(words, [&](size_t i) { return (owned.word(i) | their_owned.word(i)) & (ruled.word(i) | their_ruled.word(i)) & ~(owned.word(i) & ruled.word(i)); }, [&](ProvinceId P)
+						{
+							if (Prov.owner[P] == J.id && Prov.ruler[P] == n.first)
+							{
+								my_syn += Prov.maxman[P] / 1000.f;
+							}
+							else if (Prov.ruler[P] == J.id && Prov.owner[P] == n.first)
+							{
+								my_syn += Prov.maxman[P] / 1000.f;
+							}
+							else if (Prov.ruler[P] == n.first && Prov.owner[P] == n.first)
+							{
+								float distance = frontier[P];
+								my_syn += (Prov.maxman[P] / 1000.f) * 30 / powf(distance, 2);
+							}
+						});
+						if (my_syn > syn)
+						{
+							syn = my_syn;
+							plan.rival = n.first;
+						}
+					}
+				}
+			}
+
+			const size_t LeaderCount = myLead.size();
+			for (const auto& p : J.provinces)
+			{
+				if (LeaderCount >= J.provinces.size() / 2 + 1) break;
+				if (J.id == Prov.ruler.at(p) && Prov.Man(p, data->tick) >= 1000) plan.drafts.push_back(NationPlan::Draft{ p, Prov.Man(p, data->tick) });
+			}
+		}
+
+		for (const size_t first = plan.next; plan.next < myLead.size(); ++plan.next)
+		{
+			if ((!J.resume || plan.next > first) && ai.Expired())
+			{
+				plan.finished = false;
+				return;
+			}
+			// A resumed plan's army may name leaders lost since it started.
+			const LeaderId l = myLead[plan.next];
+			auto O = data->leaders.find(l);
+			if (O == data->leaders.end()) continue;
+			const auto& L = O->second;
+			if (L.cmd.size() == 0)
+			{
+				ProvinceId target = L.location;
+				float org_syn = prioriy.at(L.location) + L.size;
+				float syn = org_syn;
+
+				// Leaders standing together share one field until the weights change.
+				if (W.field.dist.empty() || W.field.source != L.location || W.field.mover != J.id || W.field.epoch != data->province_connect.epoch)
+					W.finder.Field(L.location, J.id, W.field);
+				for (ProvinceId P : Prov.ids())
+				{
+					if (prioriy[P] < org_syn) continue;
+					if (syn < prioriy[P] - W.field.Distance(P) * 16)
+					{
+						syn = prioriy[P] - W.field.Distance(P) * 16;
+						target = P;
+					}
+				}
+
+				if (target != L.location && W.field.Distance(target) != FLT_MAX)
+				{
+					prioriy.at(target) -= L.size;
+					prioriy.at(L.location) += L.size;
+					plan.orders.push_back(NationPlan::Order{ l, target });
+				}
+				else plan.orders.push_back(NationPlan::Order{ l, 0 });
+			}
+		}
+	}
+	else
+	{
+		const ProvinceSet& owned = N.owned;
+		const ProvinceSet& ruled = N.ruled;
+		const size_t myProvCount = CountBits(std::max(owned.word_count(), ruled.word_count()), [&](size_t i) { return owned.word(i) | ruled.word(i); });
+		size_t myLeaderCount = N.own_leaders;
+		ruled.for_each([&](ProvinceId P)
+		{
+			if (myLeaderCount < myProvCount / 2 + 1 && Prov.Man(P, data->tick) >= 1000)
+			{
+				plan.drafts.push_back(NationPlan::Draft{ P, Prov.Man(P, data->tick) });
+				++myLeaderCount;
+			}
+		});
+	}
+}
+
+void Simulation::ApplyPlan(const NationJob& J, const NationPlan& plan)
+{
+	auto& Prov = data->province;
+	Nation& N = *data->nations.at(J.id);
+	N.rival = plan.rival;
+
+	for (const auto& D : plan.drafts)
+	{
+		Draft(DraftRequest::At(D.location).Size(D.size).Owner(Prov.owner[D.location]).Sieze(N.abb_army_sieze).Move(N.abb_army_move));
+	}
+
+	for (const auto& O : plan.orders)
+	{
+		auto& L = data->leaders.at(O.leader);
+		if (O.target == 0)
+		{
+			data->SetLeaderGoal(L, 0);
+			continue;
+		}
+
+		// Every leader heading for target steps along the same field.
+		data->SetLeaderGoal(L, O.target);
+		const ProvinceId P = data->flows.Get(O.target, L.owner).Next(L.location);
+
+		L.cmd.clear();
+		L.cmd.push_back(Command(CommandType::Move, P, 0, data->province_connect.at(L.location, P) / L.abb_move));
+		data->StartOrder(O.leader, L);
+	}
+}
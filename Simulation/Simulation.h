@@ -0,0 +1,701 @@
+﻿//***************************************************************************************
+// Simulation.h
+//
+// Headless campaign simulation.  Owns provinces, nations and leaders and advances them
+// one tick at a time.  It has no dependency on Direct3D/Direct2D so it can also be
+// built and run on its own (see Simulation/Makefile).
+//***************************************************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <cfloat>
+#include <string>
+#include <memory>
+#include <list>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include <random>
+#include <initializer_list>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "SimTypes.h"
+#include "ProvinceStore.h"
+#include "ProvinceGraph.h"
+#include "PathFinder.h"
+#include "DistanceTable.h"
+#include "FrontierCache.h"
+#include "FlowField.h"
+#include "RegionGraph.h"
+#include "ContractionHierarchy.h"
+#include "PathCache.h"
+#include "TimingWheel.h"
+#include "Economy.h"
+#include "SlotMap.h"
+#include "ProvinceSet.h"
+#include "InfluenceMap.h"
+#include "AiScheduler.h"
+#include "WorkerPool.h"
+#include "CommandQueue.h"
+#include "TripleBuffer.h"
+
+struct Nation
+{
+	Float4 MainColor = { 0.f, 0.f, 0.f, 0.f };
+	std::wstring MainName = L"오류";
+	std::unordered_map<std::wstring, std::wstring> flag;
+	bool Ai = true;
+
+	float abb_disp = 1;
+	float abb_man = 1;
+	float abb_army_sieze = 1;
+	float abb_army_move = 1;
+	float abb_attr = 1;
+
+	// Kept by Data::SetOwner, SetRuler, AddLeader and EraseLeader.
+	ProvinceSet owned;
+	ProvinceSet ruled;
+	size_t own_leaders = 0;
+
+	NationId rival = NoNation;
+};
+enum class CommandType
+{
+	Move,
+	Sieze,
+	Attack
+};
+struct Command
+{
+	const CommandType type;
+	const ProvinceId target_prov;
+	const LeaderId target_leader;
+	const float need;
+	Command(const CommandType _type, const ProvinceId prov = 0, const LeaderId leader = 0, const float _need = 0) : type(_type), target_prov(prov), target_leader(leader), need(_need) {}
+};
+
+enum class LeaderType
+{
+	Attack,
+	Defend,
+	All
+};
+struct Leader
+{
+	std::list<Command> cmd;
+	// Tick the first order started counting from; Data::StartOrder books the tick it
+	// completes in Data::orders.
+	std::uint64_t cmd_start = 0;
+	// Bumped by every restart so bookings for an earlier first order are ignored.
+	std::uint32_t cmd_serial = 0;
+	bool enable = true;
+	ProvinceId location;
+	// Province the Move orders lead to, holding a reference on its flow field; 0 when
+	// none.  Changed only through Data::SetLeaderGoal.
+	ProvinceId goal = 0;
+	// Province the orders end in and the size counted there in Data::influence;
+	// changed only through Data::PlaceLeader.
+	ProvinceId bound = 0;
+	std::int64_t bound_size = 0;
+	// Selected in the UI, as of the last SelectCommand.
+	bool selected = false;
+
+	std::int64_t size = 1000;
+	LeaderType type = LeaderType::Attack;
+
+	float abb_sieze = 1;
+	float abb_move = 1;
+	float abb_disp = 1;
+
+	NationId owner;
+	Leader(const ProvinceId& loc, const NationId& own, const std::int64_t& _size) : location(loc), size(_size), owner(own) {};
+
+	// Ticks the first order has been under way as of tick now, out of its need.
+	float Progress(std::uint64_t now) const { return (float)(now - cmd_start); }
+};
+// Booking in Data::orders for the completion of a leader's first order.
+struct OrderDue
+{
+	LeaderId leader;
+	std::uint32_t serial;
+};
+struct Data
+{
+	bool run = true;
+
+	ProvinceStore province;
+	ProvinceGraph province_connect;
+	PathFinder pathfinder{ province, province_connect };
+	DistanceTable distances;
+	FrontierCache frontiers;
+	FlowFieldService flows{ province, province_connect };
+	RegionGraph regions{ province, province_connect };
+	// Optional; filled by Simulation::PrepareHierarchy.
+	ContractionHierarchy hierarchy;
+	// Paths behind Route, so repeated queries cost a lookup.
+	PathCache paths;
+	std::unordered_map<NationId, std::unique_ptr<Nation>>  nations;
+
+	SlotMap<Leader> leaders;
+	// Leaders standing in each province, indexed by ProvinceId.  Kept in step with
+	// Leader::location by AddLeader, MoveLeader and EraseLeader.
+	std::vector<std::vector<LeaderId>> leaders_at;
+	std::uint64_t leader_progress = 1;
+	// Provinces the tick still visits one by one, ascending.  The rest are quiet (see
+	// ProvinceStore::quiet) until something wakes them.
+	std::vector<ProvinceId> awake;
+	// When each leader's first order completes, so a tick only visits those that do.
+	TimingWheel<OrderDue> orders;
+	// Every nation's army strength where its leaders are heading.
+	InfluenceMap influence{ province_connect };
+
+	// Path cost per point of abb_attr for walking into a province, so routes avoid
+	// territory whose ruler bleeds armies.  Like the tick's attrition it is not paid
+	// in the mover's own territory (see ProvinceGraph::Toll).
+	float attrition_cost = 2.f;
+	std::uint64_t tick = 0;
+
+	// Province id of every map pixel, row-major, map_w * map_h.
+	size_t map_w = 0;
+	size_t map_h = 0;
+	std::vector<ProvinceId> province_pixel;
+
+	// Every random draw of the simulation goes through this engine so a run is
+	// reproducible from its seed.  Rand() mimics rand() with RAND_MAX == RandMax.
+	static constexpr int RandMax = 0x7FFF;
+	std::mt19937 mt;
+
+	Data(std::uint32_t seed) : mt(seed)
+	{
+	}
+
+	int Rand()
+	{
+		return static_cast<int>(mt() & RandMax);
+	}
+
+	Leader NewLeader(const ProvinceId& loc, const NationId& own, const std::int64_t& _size)
+	{
+		Leader L(loc, own, _size);
+		L.type = (LeaderType)(Rand() % (int)LeaderType::All);
+		return L;
+	}
+
+	LeaderId AddLeader(Leader L)
+	{
+		if (auto N = nations.find(L.owner); N != nations.end()) ++N->second->own_leaders;
+		PlaceLeader(L);
+		const ProvinceId loc = L.location;
+		const LeaderId id = leaders.insert(std::move(L));
+		if (loc >= leaders_at.size()) leaders_at.resize(loc + 1);
+		leaders_at[loc].push_back(id);
+		return id;
+	}
+
+	void MoveLeader(LeaderId id, Leader& L, ProvinceId to)
+	{
+		if (L.location == to) return;
+		const ProvinceId from = L.location;
+		UnlinkLeader(id, from);
+		L.location = to;
+		if (to >= leaders_at.size()) leaders_at.resize(to + 1);
+		leaders_at[to].push_back(id);
+		PlaceLeader(L);
+		RecheckOrders(from);
+	}
+
+	// Counts L in influence at the province its orders end in, or where it stands
+	// when it has no move orders, instead of wherever it was counted before.  Call
+	// after every change to L's size, location or orders.
+	void PlaceLeader(Leader& L)
+	{
+		ProvinceId at = L.location;
+		for (auto C = L.cmd.rbegin(); C != L.cmd.rend(); ++C)
+		{
+			if (C->type == CommandType::Move)
+			{
+				at = C->target_prov;
+				break;
+			}
+		}
+		if (at == L.bound && L.size == L.bound_size) return;
+		influence.Add(L.owner, L.bound, -L.bound_size);
+		influence.Add(L.owner, at, L.size);
+		L.bound = at;
+		L.bound_size = L.size;
+	}
+
+	// Restarts the clock on L's first order and books its completion: the first tick
+	// on which more than need ticks have passed since now.  Call after every change to
+	// the front of L.cmd.  Orders that no longer apply are dropped first.
+	void StartOrder(LeaderId id, Leader& L)
+	{
+		while (!L.cmd.empty() && Stale(L, L.cmd.front())) L.cmd.pop_front();
+		L.cmd_start = tick;
+		++L.cmd_serial;
+		PlaceLeader(L);
+		if (L.cmd.empty()) return;
+		const float need = L.cmd.front().need;
+		orders.Schedule(tick + 1 + (need > 0 ? (std::uint64_t)std::ceil(need) : 0), OrderDue{ id, L.cmd_serial });
+	}
+
+	void CancelOrder(LeaderId id, Leader& L)
+	{
+		L.cmd.pop_front();
+		StartOrder(id, L);
+	}
+
+	// Shortest walk from start to end for mover's armies.  A nation's route comes from
+	// PathFinder::Find with the tolls it pays, the costs its flow fields use, so a lone
+	// leader and a group sent to one province are routed alike.  Toll-free (NoNation)
+	// routes come from the all-pairs table or else the contraction hierarchy while they
+	// match the weights, otherwise the region graph.  Either kind is kept in paths
+	// until the costs it was found with change.
+	ProvincePath Route(ProvinceId start, ProvinceId end, NationId mover)
+	{
+		if (mover != NoNation)
+		{
+			const std::uint64_t epoch = province_connect.epoch;
+			if (const ProvincePath* P = paths.Find(start, end, mover, epoch)) return *P;
+			return paths.Insert(start, end, mover, epoch, pathfinder.Find(start, end, mover));
+		}
+
+		const std::uint64_t epoch = province_connect.weight_epoch;
+		if (const ProvincePath* P = paths.Find(start, end, mover, epoch)) return *P;
+		ProvincePath R;
+		if (!distances.empty() && distances.epoch() == epoch) R = distances.Path(start, end);
+		else if (!hierarchy.empty() && hierarchy.epoch() == epoch) R = hierarchy.Path(start, end);
+		else R = regions.Find(start, end);
+		return paths.Insert(start, end, mover, epoch, std::move(R));
+	}
+
+	// Toll ProvinceGraph charges for walking into p under its current ruler, who is
+	// exempt; the tick's attrition falls back to 5 where there is no ruling nation.
+	float RulerToll(ProvinceId p) const
+	{
+		auto N = nations.find(province.ruler[p]);
+		return attrition_cost * (N != nations.end() ? N->second->abb_attr : 5.f);
+	}
+
+	// Brings p's man and hp up to the current tick before they are written.
+	void Settle(ProvinceId p)
+	{
+		province.Settle(p, tick);
+	}
+
+	// Returns p to the tick's per-province pass, which puts it back to sleep once its
+	// owner rules it again.  Anything that changes how p regenerates calls this first.
+	void Wake(ProvinceId p)
+	{
+		if (!province.quiet[p]) return;
+		province.Settle(p, tick);
+		province.quiet[p] = 0;
+		awake.insert(std::upper_bound(awake.begin(), awake.end(), p), p);
+	}
+
+	void SetOwner(ProvinceId p, NationId owner)
+	{
+		Wake(p);
+		if (auto N = nations.find(province.owner[p]); N != nations.end()) N->second->owned.erase(p);
+		province.owner[p] = owner;
+		if (auto N = nations.find(owner); N != nations.end()) N->second->owned.insert(p);
+	}
+
+	// Every ruler change goes through here so the path costs follow.
+	void SetRuler(ProvinceId p, NationId ruler)
+	{
+		Wake(p);
+		if (auto N = nations.find(province.ruler[p]); N != nations.end()) N->second->ruled.erase(p);
+		province.ruler[p] = ruler;
+		if (auto N = nations.find(ruler); N != nations.end()) N->second->ruled.insert(p);
+		province_connect.SetToll(p, RulerToll(p), ruler);
+		RecheckOrders(p);
+	}
+
+	// Points L at a new goal, taking a reference on its flow field and dropping the
+	// one on the old goal.  goal 0 only releases.
+	void SetLeaderGoal(Leader& L, ProvinceId goal)
+	{
+		if (goal) flows.Acquire(goal, L.owner);
+		if (L.goal) flows.Release(L.goal, L.owner);
+		L.goal = goal;
+	}
+
+	// Safe while iterating leaders; the slot is released by leaders.flush().
+	void EraseLeader(LeaderId id, const Leader& L)
+	{
+		if (auto N = nations.find(L.owner); N != nations.end()) --N->second->own_leaders;
+		if (L.goal) flows.Release(L.goal, L.owner);
+		influence.Add(L.owner, L.bound, -L.bound_size);
+		UnlinkLeader(id, L.location);
+		leaders.erase_later(id);
+		RecheckOrders(L.location);
+	}
+
+	// Rebuilds every nation's sets and counters from the columns and the leaders, for
+	// when nations or provinces were loaded after the other.
+	void RecountNations()
+	{
+		for (auto& N : nations)
+		{
+			N.second->owned.clear();
+			N.second->ruled.clear();
+			N.second->own_leaders = 0;
+		}
+		for (ProvinceId O : province.ids())
+		{
+			if (auto N = nations.find(province.owner[O]); N != nations.end()) N->second->owned.insert(O);
+			if (auto N = nations.find(province.ruler[O]); N != nations.end()) N->second->ruled.insert(O);
+		}
+		for (const auto& L : leaders)
+		{
+			if (auto N = nations.find(L.second.owner); N != nations.end()) ++N->second->own_leaders;
+		}
+	}
+
+	const std::vector<LeaderId>& LeadersAt(ProvinceId loc) const
+	{
+		static const std::vector<LeaderId> none;
+		return loc < leaders_at.size() ? leaders_at[loc] : none;
+	}
+
+private:
+	// A siege of a province its ruler already holds, or an attack on a leader who is
+	// no longer standing there.
+	bool Stale(const Leader& L, const Command& C) const
+	{
+		switch (C.type)
+		{
+		case CommandType::Sieze:
+			return province.ruler[L.location] == L.owner;
+		case CommandType::Attack:
+		{
+			const auto& at = LeadersAt(L.location);
+			return std::find(at.begin(), at.end(), C.target_leader) == at.end();
+		}
+		default:
+			return false;
+		}
+	}
+
+	// Drops the first orders of the leaders at loc that lost their point.
+	void RecheckOrders(ProvinceId loc)
+	{
+		for (LeaderId l : LeadersAt(loc))
+		{
+			if (auto& A = leaders.at(l); !A.cmd.empty() && Stale(A, A.cmd.front())) StartOrder(l, A);
+		}
+	}
+
+	void UnlinkLeader(LeaderId id, ProvinceId loc)
+	{
+		if (loc >= leaders_at.size()) return;
+		auto& at = leaders_at[loc];
+		if (auto O = std::find(at.begin(), at.end(), id); O != at.end()) at.erase(O);
+	}
+};
+
+// Arguments of Simulation::Draft.  What is left unset comes from the nation ruling
+// location: the owner is that nation and the abilities are its army's.
+struct DraftRequest
+{
+	ProvinceId location = 0;
+	std::int64_t size = 1000;
+	std::optional<NationId> owner;
+	// Takes no men from the province, however many it has.
+	bool force = false;
+	std::optional<float> abb_sieze;
+	std::optional<float> abb_move;
+	std::optional<float> abb_disp;
+
+	// Names every field it sets, so no value can land in the wrong one, e.g.
+	// DraftRequest::At(26).Size(12000).Owner(owner).Forced().Sieze(4.f).Move(3.f).
+	static DraftRequest At(ProvinceId location)
+	{
+		DraftRequest R;
+		R.location = location;
+		return R;
+	}
+	DraftRequest& Size(std::int64_t value) { size = value; return *this; }
+	DraftRequest& Owner(NationId value) { owner = value; return *this; }
+	DraftRequest& Forced() { force = true; return *this; }
+	DraftRequest& Sieze(float value) { abb_sieze = value; return *this; }
+	DraftRequest& Move(float value) { abb_move = value; return *this; }
+	DraftRequest& Disp(float value) { abb_disp = value; return *this; }
+};
+
+enum class DraftResult
+{
+	Ok,
+	NoProvince,
+	NotEnoughMen
+};
+
+// What the UI asks of the simulation.  Posted from any thread and carried out by
+// Step() at the start of its next tick, in the order posted.
+struct MoveCommand
+{
+	std::vector<LeaderId> leaders;
+	ProvinceId target = 0;
+};
+// Exactly these leaders become selected.
+struct SelectCommand
+{
+	std::vector<LeaderId> leaders;
+};
+struct AiCommand
+{
+	NationId nation = 0;
+	bool ai = true;
+};
+// Text as read by LoadScenario.
+struct LoadCommand
+{
+	std::wstring scenario;
+};
+// Calls done with the text of SaveScenario(), on the stepping thread between ticks.
+struct SaveCommand
+{
+	std::function<void(const std::wstring&)> done;
+};
+using SimCommand = std::variant<DraftRequest, MoveCommand, SelectCommand, AiCommand, LoadCommand, SaveCommand>;
+
+// What the UI draws, copied out of the simulation after each Step() and never
+// changed once published.  Map data fixed by LoadMap, such as names and positions, and
+// the nations are read from Data directly.
+struct RenderSnapshot
+{
+	struct Leader
+	{
+		LeaderId id = 0;
+		NationId owner = 0;
+		ProvinceId location = 0;
+		std::int64_t size = 0;
+		// The first order, when orders is not 0; progress counts ticks towards need.
+		size_t orders = 0;
+		CommandType order = CommandType::Move;
+		ProvinceId target = 0;
+		float progress = 0;
+		float need = 0;
+		// Summed over all the orders.
+		float total_need = 0;
+		// Targets of the Move orders are route[route_begin, route_end).
+		std::uint32_t route_begin = 0;
+		std::uint32_t route_end = 0;
+	};
+
+	std::uint64_t tick = 0;
+
+	// Indexed by ProvinceId.  The colors are the nations' MainColor, zero for none.
+	std::vector<NationId> owner;
+	std::vector<NationId> ruler;
+	std::vector<Float4> owner_color;
+	std::vector<Float4> ruler_color;
+	std::vector<std::int64_t> man;
+	std::vector<std::int64_t> maxman;
+	std::vector<std::int64_t> hp;
+	// CanDraft of the default request succeeds, evaluated on the stepping thread so the
+	// UI never has to ask the live state.
+	std::vector<std::uint8_t> draftable;
+
+	// Grouped by location in Data::LeadersAt order: those at p are
+	// leaders[at[p], at[p + 1]).
+	std::vector<Leader> leaders;
+	std::vector<std::uint32_t> at;
+	std::vector<ProvinceId> route;
+	// (id, index into leaders), ascending.
+	std::vector<std::pair<LeaderId, std::uint32_t>> by_id;
+
+	const Leader* Find(LeaderId id) const
+	{
+		auto O = std::lower_bound(by_id.begin(), by_id.end(), std::make_pair(id, std::uint32_t(0)));
+		return O != by_id.end() && O->first == id ? &leaders[O->second] : nullptr;
+	}
+	std::uint32_t AtBegin(ProvinceId p) const { return p + 1 < at.size() ? at[p] : 0; }
+	std::uint32_t AtEnd(ProvinceId p) const { return p + 1 < at.size() ? at[p + 1] : 0; }
+	bool Contains(ProvinceId p) const { return p < owner.size(); }
+};
+
+class Simulation
+{
+public:
+	Simulation();
+	explicit Simulation(std::uint32_t seed);
+	Simulation(const Simulation& rhs) = delete;
+	Simulation& operator=(const Simulation& rhs) = delete;
+
+	void LoadNations();
+	// prov_list is the text of Map/prov.txt, height_bmp and prov_bmp the raw bytes of
+	// Map/map.bmp and Map/prov.bmp.
+	void LoadMap(const std::wstring& prov_list, const std::vector<unsigned char>& height_bmp, const std::vector<unsigned char>& prov_bmp);
+	// Fills data->distances from cache_path when it was written for the same map files,
+	// otherwise builds the table and writes it there.  Maps above
+	// DistanceTable::MaxProvinces get no table, and only then does it return false.
+	bool PrepareDistances(const std::string& cache_path);
+	// Same for data->hierarchy, which has no size limit.  Returns true on a cache hit.
+	bool PrepareHierarchy(const std::string& cache_path);
+	void LoadScenario(const std::wstring& text);
+	std::wstring SaveScenario() const;
+
+	// Advances the campaign by n ticks.
+	void Step(std::uint64_t n = 1);
+
+	// Raises a leader of request.size men in request.location.  Its id goes to
+	// drafted, if given, on success.
+	DraftResult Draft(const DraftRequest& request, LeaderId* drafted = nullptr);
+	// What Draft would return, without drafting.
+	DraftResult CanDraft(const DraftRequest& request) const;
+
+	// String form of the actions above for the UI and scripts: name/value pairs in,
+	// "leaderid" out of a draft, or "SUCCESS" when only_test and it would succeed.
+	std::unordered_map<std::wstring, std::wstring> Act(const std::wstring& func_name, std::initializer_list<std::wstring> args, bool only_test = false);
+
+	// Orders every leader in ids to walk to target, along its nation's shared flow
+	// field towards target for a group or a cached Data::Route for a single leader.
+	// Leaders that cannot reach it keep their orders.  Returns the Move route each
+	// leader follows afterwards, in the order of ids.
+	std::vector<ProvincePath> MoveLeaders(const std::vector<LeaderId>& ids, ProvinceId target);
+
+	// Safe from any thread while another one runs Step().
+	void Post(SimCommand command) { mCommands.Push(std::move(command)); }
+	// State as of the end of the latest Step(), for one thread other than the one
+	// stepping.  Valid until its next call.
+	const RenderSnapshot& Snapshot() { return mSnapshots.Latest(); }
+
+	std::uint32_t Seed() const { return mSeed; }
+
+	std::shared_ptr<Data> data;
+
+	// Set by Step() when a selected leader's orders progressed, or the selection or a
+	// selected leader's orders changed by a posted command.
+	bool flag_update_leaders = false;
+
+	// Messages produced while loading; the caller decides where they go.
+	std::vector<std::string> log;
+
+	// Time budget of the AI and how long each nation waits for its plans.
+	AiScheduler ai;
+
+private:
+	using Armies = std::unordered_map<NationId, std::vector<LeaderId>>;
+
+	// What a nation's planning reads besides the shared state, gathered beforehand
+	// because getting it touches caches.
+	struct NationJob
+	{
+		NationId id = 0;
+		const Nation* nation = nullptr;
+		// This tick's leaders, or mPending.army when resuming.
+		const std::vector<LeaderId>* army = nullptr;
+		// Going on from leader next of a plan the budget cut short.
+		bool resume = false;
+		size_t next = 0;
+		// Nation::rival, or NoNation once that nation is gone.
+		NationId rival = NoNation;
+		// Owned or ruled, ascending; left empty when resuming.
+		std::vector<ProvinceId> provinces;
+		// Set when a new rival is to be picked.
+		const std::vector<float>* frontier = nullptr;
+		// Influence fields, set when some leader from next on is idle and the
+		// priorities are not carried over from where the plan stopped.
+		const std::vector<float>* total = nullptr;
+		const std::vector<float>* mine = nullptr;
+	};
+	// What a nation decided, for ApplyPlan.  Every field is set by PlanNation.
+	struct NationPlan
+	{
+		struct Draft
+		{
+			ProvinceId location;
+			std::int64_t size;
+		};
+		// target 0 only drops the leader's goal.
+		struct Order
+		{
+			LeaderId leader;
+			ProvinceId target;
+		};
+
+		NationId rival = NoNation;
+		std::vector<Draft> drafts;
+		std::vector<Order> orders;
+		bool finished = true;
+		size_t next = 0;
+		double us = 0;
+		// Province priorities as the orders so far left them; empty when no leader
+		// needed them.  A resumed plan goes on with the ones it stopped with.
+		std::vector<float> prioriy;
+	};
+	// Scratch of one pool thread.
+	struct AiWorker
+	{
+		PathFinder finder;
+		// Reused while the next leader planned stands in the same province and the
+		// weights are unchanged.
+		DistanceField field;
+
+		AiWorker(const ProvinceStore& prov, const ProvinceGraph& graph) : finder(prov, graph) {}
+	};
+
+	void Tick();
+	// Carries out everything posted so far.
+	void ApplyCommands();
+	// Fills the back snapshot from the current state and hands it to Snapshot().
+	void Publish();
+	// Runs the AI for as many nations as ai allows this tick: each plans on the pool
+	// against the state as it was, then the plans are applied in nation id order.
+	void PlanNations();
+	void PrepareNation(NationJob& J, NationId id, Armies& armies, bool resume, size_t next);
+	// Only reads the simulation.  Stops early when the budget runs out, leaving
+	// plan.finished false and plan.next at the leader to go on with.
+	void PlanNation(const NationJob& J, AiWorker& W, NationPlan& plan) const;
+	void ApplyPlan(const NationJob& J, const NationPlan& plan);
+	void Query(const std::wstring& query);
+
+	std::uint32_t mSeed;
+	// Hash of the map files given to LoadMap, used as the distance cache key.
+	std::uint64_t mMapKey = 0;
+	// Scratch columns of the awake provinces for the regeneration kernels.
+	EconomyBatch mEconomy;
+	std::unique_ptr<WorkerPool> mPool;
+	// ai.threads mPool was made for.
+	size_t mPoolThreads = 0;
+	std::vector<std::unique_ptr<AiWorker>> mWorkers;
+	// Kept between ticks for their buffers.
+	std::vector<NationJob> mJobs;
+	std::vector<NationPlan> mPlans;
+	// What the plan the budget cut short needs to go on where it stopped.
+	struct PendingPlan
+	{
+		// The nation's leaders as they were when the plan started; ai.cursor.leader
+		// indexes them, so leaders drafted or lost since do not shift the rest.
+		std::vector<LeaderId> army;
+		// NationPlan::prioriy where it stopped.
+		std::vector<float> prioriy;
+	};
+	PendingPlan mPending;
+	CommandQueue<SimCommand> mCommands;
+	TripleBuffer<RenderSnapshot> mSnapshots;
+
+	struct Query
+	{
+		bool enable = false;
+
+		bool isString = false;
+		bool isLineComment = false;
+		bool isComment = false;
+
+		size_t pos;
+		std::list<std::wstring> word;
+		std::wstring index;
+
+		ProvinceId tag_prov;
+		LeaderId tag_leader;
+
+	} mQuery;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Generation-checked handle container.
+//
+// Values live densely in one vector so iteration is a linear walk, and a key is
+// (generation << 32 | slot).  Erasing bumps the slot's generation, so a stale key
+// never resolves to the value that later reuses the slot.  Slot 0 is never handed
+// out, which keeps key 0 free to mean "none".
+//
+// Erasing moves the last value into the hole, so it invalidates references and
+// iterators.  Use erase_later() while iterating and flush() afterwards.
+template <class T>
+class SlotMap
+{
+public:
+	using key_type = std::uint64_t;
+	using value_type = std::pair<key_type, T>;
+	using iterator = typename std::vector<value_type>::iterator;
+	using const_iterator = typename std::vector<value_type>::const_iterator;
+
+	SlotMap() : mSlots(1) {}
+
+	iterator begin() { return mDense.begin(); }
+	iterator end() { return mDense.end(); }
+	const_iterator begin() const { return mDense.begin(); }
+	const_iterator end() const { return mDense.end(); }
+	size_t size() const { return mDense.size(); }
+	bool empty() const { return mDense.empty(); }
+
+	key_type insert(T value)
+	{
+		std::uint32_t slot;
+		if (!mFree.empty())
+		{
+			slot = mFree.back();
+			mFree.pop_back();
+		}
+		else
+		{
+			slot = (std::uint32_t)mSlots.size();
+			mSlots.push_back(Slot());
+		}
+
+		const key_type key = ((key_type)mSlots[slot].generation << 32) | slot;
+		mSlots[slot].dense = (std::uint32_t)mDense.size();
+		mDense.emplace_back(key, std::move(value));
+		return key;
+	}
+
+	iterator find(key_type key)
+	{
+		if (const Slot* S = Resolve(key)) return mDense.begin() + S->dense;
+		return mDense.end();
+	}
+	const_iterator find(key_type key) const
+	{
+		if (const Slot* S = Resolve(key)) return mDense.begin() + S->dense;
+		return mDense.end();
+	}
+	bool contains(key_type key) const { return Resolve(key) != nullptr; }
+
+	T& at(key_type key)
+	{
+		if (const Slot* S = Resolve(key)) return mDense[S->dense].second;
+		throw std::out_of_range("SlotMap::at");
+	}
+	const T& at(key_type key) const
+	{
+		if (const Slot* S = Resolve(key)) return mDense[S->dense].second;
+		throw std::out_of_range("SlotMap::at");
+	}
+
+	bool erase(key_type key)
+	{
+		const Slot* S = Resolve(key);
+		if (!S) return false;
+
+		const std::uint32_t slot = (std::uint32_t)(key & 0xFFFFFFFFu);
+		const std::uint32_t hole = S->dense;
+		if (hole + 1 != mDense.size())
+		{
+			mDense[hole] = std::move(mDense.back());
+			mSlots[mDense[hole].first & 0xFFFFFFFFu].dense = hole;
+		}
+		mDense.pop_back();
+
+		++mSlots[slot].generation;
+		mFree.push_back(slot);
+		return true;
+	}
+
+	// Queues key for removal by the next flush(); lookups keep resolving it until then.
+	void erase_later(key_type key) { mPending.push_back(key); }
+	void flush()
+	{
+		for (key_type key : mPending) erase(key);
+		mPending.clear();
+	}
+
+	void clear()
+	{
+		for (const auto& O : mDense) erase_later(O.first);
+		flush();
+	}
+
+private:
+	struct Slot
+	{
+		std::uint32_t dense = 0;
+		std::uint32_t generation = 0;
+	};
+
+	const Slot* Resolve(key_type key) const
+	{
+		const std::uint32_t slot = (std::uint32_t)(key & 0xFFFFFFFFu);
+		if (slot == 0 || slot >= mSlots.size()) return nullptr;
+		const Slot& S = mSlots[slot];
+		if (S.generation != (std::uint32_t)(key >> 32) || S.dense >= mDense.size()) return nullptr;
+		if (mDense[S.dense].first != key) return nullptr;
+		return &S;
+	}
+
+	std::vector<value_type> mDense;
+	std::vector<Slot> mSlots;
+	std::vector<std::uint32_t> mFree;
+	std::vector<key_type> mPending;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Hierarchical timing wheel: Levels rings of 2^SlotBits slots, each level counting
+// in steps of the whole ring below it.  Booking is O(1), and advancing one tick
+// touches the slot that comes due plus, when a ring wraps, the one slot of the next
+// level that is redistributed downwards.  Dues beyond the top ring wait in an
+// overflow list that is rechecked each time the top ring wraps.
+//
+// Values due on the same tick come out in the order they were booked.
+template <class T>
+class TimingWheel
+{
+public:
+	static constexpr unsigned SlotBits = 6;
+	static constexpr unsigned Levels = 4;
+	static constexpr std::uint64_t Slots = 1ull << SlotBits;
+
+	// Last tick handed to Advance.
+	std::uint64_t now() const { return mNow; }
+	size_t size() const { return mCount; }
+
+	// Books value for tick due.  A due that is not in the future fires on the next tick.
+	void Schedule(std::uint64_t due, T value)
+	{
+		Place(due > mNow ? due : mNow + 1, std::move(value));
+		++mCount;
+	}
+
+	// Runs the clock up to tick and appends what came due on the way to out.
+	void Advance(std::uint64_t tick, std::vector<T>& out)
+	{
+		while (mNow < tick)
+		{
+			++mNow;
+			if ((mNow & Mask(Levels)) == 0) Cascade(mOverflow);
+			for (unsigned l = Levels - 1; l > 0; --l)
+			{
+				if ((mNow & Mask(l)) == 0) Cascade(mSlots[l][(mNow >> (SlotBits * l)) & (Slots - 1)]);
+			}
+
+			auto& S = mSlots[0][mNow & (Slots - 1)];
+			for (auto& E : S) out.push_back(std::move(E.value));
+			mCount -= S.size();
+			S.clear();
+		}
+	}
+
+	void clear()
+	{
+		for (auto& Level : mSlots)
+		{
+			for (auto& S : Level) S.clear();
+		}
+		mOverflow.clear();
+		mCount = 0;
+	}
+
+private:
+	struct Entry
+	{
+		std::uint64_t due;
+		T value;
+	};
+	using Slot = std::vector<Entry>;
+
+	// Ticks spanned by one slot of level l, minus one.
+	static constexpr std::uint64_t Mask(unsigned l) { return (1ull << (SlotBits * l)) - 1; }
+
+	// The lowest level on which due and mNow fall in the same turn of the ring above.
+	void Place(std::uint64_t due, T value)
+	{
+		for (unsigned l = 0; l < Levels; ++l)
+		{
+			if ((due >> (SlotBits * (l + 1))) == (mNow >> (SlotBits * (l + 1))))
+			{
+				mSlots[l][(due >> (SlotBits * l)) & (Slots - 1)].push_back(Entry{ due, std::move(value) });
+				return;
+			}
+		}
+		mOverflow.push_back(Entry{ due, std::move(value) });
+	}
+
+	void Cascade(Slot& S)
+	{
+		mSpill.swap(S);
+		for (auto& E : mSpill) Place(E.due, std::move(E.value));
+		mSpill.clear();
+	}
+
+	std::uint64_t mNow = 0;
+	size_t mCount = 0;
+	Slot mSlots[Levels][Slots];
+	Slot mOverflow;
+	Slot mSpill;
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+
+// Hands values from one writer thread to one reader thread without either waiting.
+// There are three slots: the writer fills its own back slot, and Publish swaps it
+// with the middle slot and marks the middle fresh.  The reader swaps its front slot
+// with the middle only when the middle is fresh.  Neither side ever sees the slot
+// the other is using, so a value is left alone once published.  The reader always
+// gets the newest value, and values it was too slow for are skipped.
+//
+// A slot comes back to the writer holding a value from two Publishes ago, so a
+// writer that overwrites it in place keeps its buffers.
+template<class T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const TripleBuffer& rhs) = delete;
+	TripleBuffer& operator=(const TripleBuffer& rhs) = delete;
+
+	// Writer only.
+	T& Back() { return mSlots[mBack]; }
+	void Publish() { mBack = mMiddle.exchange(mBack | Fresh, std::memory_order_acq_rel) & Index; }
+
+	// Reader only.  The newest published value, which stays put until the next call.
+	// A default T until the first Publish.
+	const T& Latest()
+	{
+		if (mMiddle.load(std::memory_order_relaxed) & Fresh)
+			mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & Index;
+		return mSlots[mFront];
+	}
+
+private:
+	static constexpr unsigned Index = 3;
+	static constexpr unsigned Fresh = 4;
+
+	T mSlots[3];
+	// Index of the middle slot, or'ed with Fresh when it holds a value not yet read.
+	std::atomic<unsigned> mMiddle{ 1 };
+	unsigned mBack = 0;
+	unsigned mFront = 2;
+};
@@ -0,0 +1,69 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t threads)
+{
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	for (size_t i = 1; i < threads; ++i) mThreads.emplace_back(&WorkerPool::Loop, this, i);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWake.notify_all();
+	for (auto& T : mThreads) T.join();
+}
+
+void WorkerPool::Run(size_t count, const std::function<void(size_t, size_t)>& fn)
+{
+	if (count == 0) return;
+	// Not worth waking anyone for.
+	if (count == 1 || mThreads.empty())
+	{
+		for (size_t i = 0; i < count; ++i) fn(i, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFn = &fn;
+		mCount = count;
+		mNext = 0;
+		mBusy = mThreads.size();
+		++mRound;
+	}
+	mWake.notify_all();
+	Drain(0);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDone.wait(lock, [this] { return mBusy == 0; });
+	mFn = nullptr;
+}
+
+void WorkerPool::Loop(size_t worker)
+{
+	std::uint64_t seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [&] { return mStop || mRound != seen; });
+			if (mStop) return;
+			seen = mRound;
+		}
+		Drain(worker);
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (--mBusy == 0) mDone.notify_one();
+		}
+	}
+}
+
+void WorkerPool::Drain(size_t worker)
+{
+	for (size_t i; (i = mNext.fetch_add(1)) < mCount;) (*mFn)(i, worker);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads kept alive between calls so a tick can fan work out without starting any.
+// Run(count, fn) calls fn(i, worker) once for every i below count, spread over the
+// pool and the calling thread, and returns once all calls are done.  worker is below
+// size() and no two calls running at the same time share one, so it can index
+// per-worker scratch.
+class WorkerPool
+{
+public:
+	// threads counts the caller; 0 means one per hardware thread.
+	explicit WorkerPool(size_t threads);
+	~WorkerPool();
+	WorkerPool(const WorkerPool& rhs) = delete;
+	WorkerPool& operator=(const WorkerPool& rhs) = delete;
+
+	size_t size() const { return mThreads.size() + 1; }
+
+	void Run(size_t count, const std::function<void(size_t, size_t)>& fn);
+
+private:
+	void Loop(size_t worker);
+	void Drain(size_t worker);
+
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	std::condition_variable mDone;
+
+	// Bumped for every Run so sleeping threads can tell there is new work.
+	std::uint64_t mRound = 0;
+	size_t mBusy = 0;
+	bool mStop = false;
+
+	const std::function<void(size_t, size_t)>* mFn = nullptr;
+	size_t mCount = 0;
+	std::atomic<size_t> mNext{ 0 };
+};